@@ -0,0 +1,247 @@
+// Microbenchmarks for the PicoGraphics primitives, run on the host against every pen type.
+//
+// Usage: bench_graphics [min_ms_per_case]
+//
+// Every primitive is timed on every pen at 320x240 (ST7789) and 128x64 (SSD1306). The inputs are
+// generated once from a fixed seed so runs are comparable, and the number of pixels each workload
+// touches is measured with a counting pen so the results can be reported per pixel.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ST7789VW/pico_graphics.hpp"
+
+namespace {
+
+    // Pen that only counts how many pixels would be written
+    class PicoGraphics_PenCount : public PicoGraphics {
+    public:
+        uint64_t pixels = 0;
+
+        PicoGraphics_PenCount(uint16_t width, uint16_t height) : PicoGraphics(width, height, nullptr) {}
+
+        void set_pen(uint) override {}
+
+        void set_pen(uint8_t, uint8_t, uint8_t) override {}
+
+        void set_pixel(const Point &) override { pixels++; }
+
+        void set_pixel_span(const Point &, uint l) override { pixels += l; }
+
+        void set_pixel_alpha(const Point &, uint8_t) override { pixels++; }
+    };
+
+    struct Target {
+        std::string name;
+        std::vector<uint8_t> buffer;
+        std::unique_ptr<PicoGraphics> graphics;
+    };
+
+    template<typename PenT>
+    Target make_target(const char * name, uint16_t w, uint16_t h) {
+        Target t;
+        t.name = name;
+        t.buffer.resize(PenT::buffer_size(w, h));
+        t.graphics.reset(new PenT(w, h, t.buffer.data()));
+        t.graphics->set_pen(255, 255, 255);
+        return t;
+    }
+
+    std::vector<Target> make_targets(uint16_t w, uint16_t h) {
+        std::vector<Target> targets;
+        targets.push_back(make_target<PicoGraphics_Pen1Bit>("1bit", w, h));
+        targets.push_back(make_target<PicoGraphics_Pen1BitY>("1bitY", w, h));
+        targets.push_back(make_target<PicoGraphics_Pen3Bit>("3bit", w, h));
+        targets.back().graphics->set_pen(1);  // 3bit ignores RGB pens, use white from the palette
+        targets.push_back(make_target<PicoGraphics_PenP4>("P4", w, h));
+        targets.push_back(make_target<PicoGraphics_PenP8>("P8", w, h));
+        targets.push_back(make_target<PicoGraphics_PenRGB332>("RGB332", w, h));
+        targets.push_back(make_target<PicoGraphics_PenRGB565>("RGB565", w, h));
+        targets.push_back(make_target<PicoGraphics_PenRGB888>("RGB888", w, h));
+        return targets;
+    }
+
+    // xorshift32, deterministic across platforms
+    struct Random {
+        uint32_t state = 0x12345678;
+
+        int32_t next(int32_t lo, int32_t hi) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return lo + int32_t(state % uint32_t(hi - lo + 1));
+        }
+    };
+
+    struct Workload {
+        const char * name;
+        std::function<void(PicoGraphics & g)> draw;
+    };
+
+    std::vector<Workload> make_workloads(int32_t w, int32_t h) {
+        Random rnd;
+
+        // coordinates reach a little outside the screen so clipping is exercised as well
+        auto point = [&]() { return Point(rnd.next(-w / 8, w + w / 8), rnd.next(-h / 8, h + h / 8)); };
+
+        std::vector<Point> pixels;
+        for (int i = 0; i < 1024; i++) pixels.push_back(point());
+
+        std::vector<std::pair<Point, int32_t>> spans;
+        for (int i = 0; i < 256; i++) spans.emplace_back(point(), rnd.next(1, w / 2));
+
+        std::vector<Rect> rects;
+        for (int i = 0; i < 64; i++) rects.emplace_back(point(), point());
+        for (auto & r: rects) {
+            if (r.w < 0) { r.x += r.w; r.w = -r.w; }
+            if (r.h < 0) { r.y += r.h; r.h = -r.h; }
+        }
+
+        // 1x6 columns across the screen, as draw_fast() plots its waves
+        std::vector<Rect> columns;
+        for (int32_t x = 0; x < w; x++) columns.emplace_back(x, rnd.next(0, h - 6), 1, 6);
+
+        std::vector<Span> span_batch;
+        for (auto & s: spans) span_batch.emplace_back(s.first, s.second);
+
+        std::vector<std::pair<Point, Point>> lines;
+        for (int i = 0; i < 128; i++) lines.emplace_back(point(), point());
+
+        std::vector<std::pair<Point, int32_t>> circles;
+        for (int i = 0; i < 32; i++) circles.emplace_back(point(), rnd.next(1, h / 4));
+
+        std::vector<std::array<Point, 3>> triangles;
+        for (int i = 0; i < 32; i++) triangles.push_back({point(), point(), point()});
+
+        std::vector<std::vector<Point>> polygons;
+        for (int i = 0; i < 8; i++) {
+            std::vector<Point> poly;
+            for (int j = 0; j < 8; j++) poly.push_back(point());
+            polygons.push_back(poly);
+        }
+
+        // a 128x128 sprite sheet of mostly opaque runs, as RGB332 for sprite() and RGB565 for blit()
+        auto sheet332 = std::make_shared<std::vector<uint8_t>>(128 * 128);
+        auto sheet565 = std::make_shared<std::vector<uint16_t>>(128 * 128);
+        for (size_t i = 0; i < sheet332->size(); i++) {
+            (*sheet332)[i] = (i / 5) % 7 == 0 ? 0 : uint8_t(i / 3);
+            (*sheet565)[i] = PicoGraphics::rgb332_to_rgb565((*sheet332)[i]);
+        }
+
+        std::vector<std::pair<Point, Point>> sprites;
+        for (int i = 0; i < 64; i++) sprites.emplace_back(Point(rnd.next(0, 15), rnd.next(0, 15)), point());
+
+        return {
+                {"sprite",     [=](PicoGraphics & g) {
+                    for (auto & s: sprites) g.sprite(sheet332->data(), s.first, s.second, 2, 0);
+                }},
+                {"blit",       [=](PicoGraphics & g) {
+                    PicoGraphics::Bitmap bitmap{PicoGraphics::PEN_RGB565, sheet565->data(), 128, 128, 128 * 2};
+                    bitmap.transparent = 0;
+                    for (auto & s: sprites) g.blit(bitmap, Rect(s.first.x * 8, s.first.y * 8, 32, 24), s.second);
+                }},
+                {"clear",      [](PicoGraphics & g) { g.clear(); }},
+                {"pixel",      [=](PicoGraphics & g) { for (auto & p: pixels) g.pixel(p); }},
+                {"pixels",     [=](PicoGraphics & g) { g.pixels(pixels.data(), pixels.size()); }},
+                {"pixel_span", [=](PicoGraphics & g) { for (auto & s: spans) g.pixel_span(s.first, s.second); }},
+                {"pixel_spans", [=](PicoGraphics & g) { g.pixel_spans(span_batch.data(), span_batch.size()); }},
+                {"rectangle",  [=](PicoGraphics & g) { for (auto & r: rects) g.rectangle(r); }},
+                {"rectangles", [=](PicoGraphics & g) { g.rectangles(rects.data(), rects.size()); }},
+                {"column",     [=](PicoGraphics & g) { for (auto & r: columns) g.rectangle(r); }},
+                {"columns",    [=](PicoGraphics & g) { g.rectangles(columns.data(), columns.size()); }},
+                {"rect_blend", [=](PicoGraphics & g) {
+                    g.set_blend(128);
+                    for (auto & r: rects) g.rectangle(r);
+                    g.set_blend(255);
+                }},
+                {"line",       [=](PicoGraphics & g) { for (auto & l: lines) g.line(l.first, l.second); }},
+                {"line_aa",    [=](PicoGraphics & g) { for (auto & l: lines) g.line_aa(l.first, l.second); }},
+                {"circle",     [=](PicoGraphics & g) { for (auto & c: circles) g.circle(c.first, c.second); }},
+                {"circle_aa",  [=](PicoGraphics & g) { for (auto & c: circles) g.circle_outline_aa(c.first, c.second); }},
+                {"triangle",   [=](PicoGraphics & g) { for (auto & t: triangles) g.triangle(t[0], t[1], t[2]); }},
+                {"polygon",    [=](PicoGraphics & g) { for (auto & p: polygons) g.polygon(p); }},
+        };
+    }
+
+    double run_case(PicoGraphics & g, const Workload & workload, double min_ns) {
+        using clock = std::chrono::steady_clock;
+
+        workload.draw(g);  // warm up
+
+        uint64_t iterations = 0;
+        auto const start = clock::now();
+        double elapsed;
+        do {
+            workload.draw(g);
+            iterations++;
+            elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        } while (elapsed < min_ns);
+
+        return elapsed / double(iterations);
+    }
+
+    // frame_convert() to RGB565 as used by the ST7789 driver, and to P4 for 3bit, for the pens that support it
+    void bench_convert(uint16_t w, uint16_t h, double min_ns) {
+        auto targets = make_targets(w, h);
+
+        std::pair<PicoGraphics::PenType, const char *> const types[] = {
+                {PicoGraphics::PEN_RGB565, "convert"},
+                {PicoGraphics::PEN_P4,     "convert_p4"},
+        };
+
+        for (auto & type: types) {
+            for (auto & target: targets) {
+                size_t bytes = 0;
+                auto convert = [&](PicoGraphics & g) {
+                    g.frame_convert(type.first, [&bytes](void *, size_t length) {
+                        bytes += length;
+                    });
+                };
+
+                convert(*target.graphics);
+                if (bytes == 0) continue;
+
+                double const ns = run_case(*target.graphics, {type.second, convert}, min_ns);
+                double const ns_per_pixel = ns / (double(w) * h);
+                printf("%3dx%-3d  %-7s %-11s %10.3f ns/px %10.2f Mpx/s\n",
+                       w, h, target.name.c_str(), type.second, ns_per_pixel, 1e3 / ns_per_pixel);
+            }
+        }
+    }
+
+    void bench_size(uint16_t w, uint16_t h, double min_ns) {
+        auto const workloads = make_workloads(w, h);
+        auto targets = make_targets(w, h);
+
+        for (auto & workload: workloads) {
+            PicoGraphics_PenCount counter(w, h);
+            workload.draw(counter);
+            double const pixels = double(std::max<uint64_t>(counter.pixels, 1));
+
+            for (auto & target: targets) {
+                double const ns = run_case(*target.graphics, workload, min_ns);
+                double const ns_per_pixel = ns / pixels;
+                printf("%3dx%-3d  %-7s %-11s %10.3f ns/px %10.2f Mpx/s\n",
+                       w, h, target.name.c_str(), workload.name, ns_per_pixel, 1e3 / ns_per_pixel);
+            }
+        }
+    }
+
+}
+
+int main(int argc, char ** argv) {
+    double const min_ms = argc > 1 ? atof(argv[1]) : 50.0;
+
+    bench_size(320, 240, min_ms * 1e6);
+    bench_size(128, 64, min_ms * 1e6);
+    bench_convert(320, 240, min_ms * 1e6);
+
+    return 0;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+typedef volatile uint32_t io_rw_32;
+typedef const volatile uint32_t io_ro_32;
+typedef volatile uint32_t io_wo_32;
+
+static inline void hw_write_masked(io_rw_32 * addr, uint32_t values, uint32_t write_mask) {
+    *addr = (*addr & ~write_mask) | (values & write_mask);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <sys/types.h>
+
+enum clock_index {
+    clk_gpout0 = 0,
+    clk_gpout1,
+    clk_gpout2,
+    clk_gpout3,
+    clk_ref,
+    clk_sys,
+    clk_peri,
+    clk_usb,
+    clk_adc,
+    clk_rtc,
+    CLK_COUNT
+};
+
+static inline uint32_t clock_get_hz(clock_index clk_index) {
+    return clk_index == clk_sys || clk_index == clk_peri ? 125'000'000 : 48'000'000;
+}
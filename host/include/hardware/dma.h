@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sys/types.h>
+
+#include "hardware/irq.h"
+
+#define NUM_DMA_CHANNELS 12
+
+#define DREQ_FORCE 0x3f
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2
+};
+
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+
+// ctrl bit layout used by the shim (not the hardware layout)
+#define HOST_DMA_SIZE_MASK 0x3u
+#define HOST_DMA_READ_INCR 0x4u
+#define HOST_DMA_WRITE_INCR 0x8u
+#define HOST_DMA_BSWAP 0x10u
+
+struct host_dma_channel {
+    bool claimed;
+    dma_channel_config config;
+    volatile void * write_addr;
+    const volatile void * read_addr;
+    uint32_t trans_count;
+    bool irq0_enabled;
+    bool irq0_status;
+    uint64_t bytes_transferred;  // host only: total bytes moved by this channel
+};
+
+inline host_dma_channel host_dma[NUM_DMA_CHANNELS] = {};
+
+static inline int dma_claim_unused_channel(bool required) {
+    for (int i = 0; i < NUM_DMA_CHANNELS; i++) {
+        if (!host_dma[i].claimed) {
+            host_dma[i].claimed = true;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static inline void dma_channel_claim(uint channel) {
+    host_dma[channel].claimed = true;
+}
+
+static inline void dma_channel_unclaim(uint channel) {
+    host_dma[channel].claimed = false;
+}
+
+static inline bool dma_channel_is_claimed(uint channel) {
+    return host_dma[channel].claimed;
+}
+
+static inline dma_channel_config dma_channel_get_default_config(uint channel) {
+    return {DMA_SIZE_32 | HOST_DMA_READ_INCR};
+}
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config * c, dma_channel_transfer_size size) {
+    c->ctrl = (c->ctrl & ~HOST_DMA_SIZE_MASK) | size;
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config * c, bool incr) {
+    c->ctrl = incr ? (c->ctrl | HOST_DMA_READ_INCR) : (c->ctrl & ~HOST_DMA_READ_INCR);
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config * c, bool incr) {
+    c->ctrl = incr ? (c->ctrl | HOST_DMA_WRITE_INCR) : (c->ctrl & ~HOST_DMA_WRITE_INCR);
+}
+
+static inline void channel_config_set_bswap(dma_channel_config * c, bool bswap) {
+    c->ctrl = bswap ? (c->ctrl | HOST_DMA_BSWAP) : (c->ctrl & ~HOST_DMA_BSWAP);
+}
+
+static inline void channel_config_set_dreq(dma_channel_config * c, uint dreq) {}
+
+static inline void channel_config_set_chain_to(dma_channel_config * c, uint chain_to) {}
+
+static inline void channel_config_set_ring(dma_channel_config * c, bool write, uint size_bits) {}
+
+// The shim completes transfers as soon as they are triggered: memory targets are copied, peripheral
+// targets only have the bytes counted. The completion interrupt is raised if it is enabled.
+static inline void host_dma_run(uint channel) {
+    host_dma_channel & ch = host_dma[channel];
+    size_t const size = 1u << (ch.config.ctrl & HOST_DMA_SIZE_MASK);
+    size_t const bytes = size_t(ch.trans_count) * size;
+
+    if ((ch.config.ctrl & HOST_DMA_WRITE_INCR) && (ch.config.ctrl & HOST_DMA_READ_INCR)) {
+        memcpy((void *) ch.write_addr, (const void *) ch.read_addr, bytes);
+    }
+    if (ch.config.ctrl & HOST_DMA_READ_INCR) ch.read_addr = (const volatile uint8_t *) ch.read_addr + bytes;
+    if (ch.config.ctrl & HOST_DMA_WRITE_INCR) ch.write_addr = (volatile uint8_t *) ch.write_addr + bytes;
+
+    ch.bytes_transferred += bytes;
+    ch.trans_count = 0;
+    ch.irq0_status = true;
+    if (ch.irq0_enabled) host_irq_raise(DMA_IRQ_0);
+}
+
+static inline void dma_channel_configure(uint channel, const dma_channel_config * config, volatile void * write_addr,
+                                         const volatile void * read_addr, uint transfer_count, bool trigger) {
+    host_dma_channel & ch = host_dma[channel];
+    ch.config = *config;
+    ch.write_addr = write_addr;
+    ch.read_addr = read_addr;
+    ch.trans_count = transfer_count;
+    if (trigger) host_dma_run(channel);
+}
+
+static inline void dma_channel_set_config(uint channel, const dma_channel_config * config, bool trigger) {
+    host_dma[channel].config = *config;
+    if (trigger) host_dma_run(channel);
+}
+
+static inline void dma_channel_set_read_addr(uint channel, const volatile void * read_addr, bool trigger) {
+    host_dma[channel].read_addr = read_addr;
+    if (trigger) host_dma_run(channel);
+}
+
+static inline void dma_channel_set_write_addr(uint channel, volatile void * write_addr, bool trigger) {
+    host_dma[channel].write_addr = write_addr;
+    if (trigger) host_dma_run(channel);
+}
+
+static inline void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger) {
+    host_dma[channel].trans_count = trans_count;
+    if (trigger) host_dma_run(channel);
+}
+
+static inline void dma_channel_transfer_from_buffer_now(uint channel, const volatile void * read_addr,
+                                                        uint32_t transfer_count) {
+    host_dma[channel].read_addr = read_addr;
+    host_dma[channel].trans_count = transfer_count;
+    host_dma_run(channel);
+}
+
+static inline void dma_channel_start(uint channel) {
+    host_dma_run(channel);
+}
+
+static inline bool dma_channel_is_busy(uint channel) {
+    return false;
+}
+
+static inline void dma_channel_wait_for_finish_blocking(uint channel) {}
+
+static inline void dma_channel_abort(uint channel) {}
+
+static inline void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+    host_dma[channel].irq0_enabled = enabled;
+}
+
+static inline bool dma_channel_get_irq0_status(uint channel) {
+    return host_dma[channel].irq0_status && host_dma[channel].irq0_enabled;
+}
+
+static inline void dma_channel_acknowledge_irq0(uint channel) {
+    host_dma[channel].irq0_status = false;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <sys/types.h>
+
+#define NUM_BANK0_GPIOS 30
+
+enum gpio_function {
+    GPIO_FUNC_XIP = 0,
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PIO0 = 6,
+    GPIO_FUNC_PIO1 = 7,
+    GPIO_FUNC_GPCK = 8,
+    GPIO_FUNC_USB = 9,
+    GPIO_FUNC_NULL = 0x1f,
+};
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+enum gpio_slew_rate {
+    GPIO_SLEW_RATE_SLOW = 0,
+    GPIO_SLEW_RATE_FAST = 1
+};
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+typedef void (* gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+struct host_gpio_state {
+    bool value[NUM_BANK0_GPIOS];
+    uint32_t irq_events[NUM_BANK0_GPIOS];
+    gpio_irq_callback_t callback;
+};
+
+inline host_gpio_state host_gpio = {};
+
+static inline void gpio_init(uint gpio) {}
+
+static inline void gpio_set_function(uint gpio, gpio_function fn) {}
+
+static inline void gpio_set_dir(uint gpio, bool out) {}
+
+static inline void gpio_pull_up(uint gpio) {}
+
+static inline void gpio_set_slew_rate(uint gpio, gpio_slew_rate slew) {}
+
+static inline void gpio_put(uint gpio, bool value) {
+    if (gpio < NUM_BANK0_GPIOS) host_gpio.value[gpio] = value;
+}
+
+static inline bool gpio_get(uint gpio) {
+    return gpio < NUM_BANK0_GPIOS && host_gpio.value[gpio];
+}
+
+static inline void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled) {
+    if (gpio >= NUM_BANK0_GPIOS) return;
+    host_gpio.irq_events[gpio] = enabled ? (host_gpio.irq_events[gpio] | events) : (host_gpio.irq_events[gpio] & ~events);
+}
+
+static inline void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled,
+                                                      gpio_irq_callback_t callback) {
+    gpio_set_irq_enabled(gpio, events, enabled);
+    host_gpio.callback = callback;
+}
+
+static inline void gpio_acknowledge_irq(uint gpio, uint32_t events) {}
+
+// Host only: raise `events` on `gpio` as if the pin had changed, calling the registered callback
+static inline void host_gpio_trigger(uint gpio, uint32_t events) {
+    if (gpio < NUM_BANK0_GPIOS && (host_gpio.irq_events[gpio] & events) && host_gpio.callback) {
+        host_gpio.callback(gpio, host_gpio.irq_events[gpio] & events);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "hardware/address_mapped.h"
+
+#define I2C_IC_DATA_CMD_STOP_BITS 0x00000200
+#define I2C_IC_DATA_CMD_RESTART_BITS 0x00000400
+#define I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS 0x00000040
+#define I2C_IC_TX_BUFFER_DEPTH 16
+#define I2C_IC_STATUS_ACTIVITY_BITS 0x00000001
+
+#define DREQ_I2C0_TX 32
+#define DREQ_I2C0_RX 33
+#define DREQ_I2C1_TX 34
+#define DREQ_I2C1_RX 35
+
+// subset of the registers, in hardware order
+typedef struct {
+    io_rw_32 con;
+    io_rw_32 tar;
+    io_rw_32 sar;
+    uint32_t _pad0;
+    io_rw_32 data_cmd;
+    io_rw_32 raw_intr_stat;
+    io_ro_32 clr_tx_abrt;
+    io_rw_32 enable;
+    io_ro_32 status;
+    io_ro_32 txflr;
+    io_ro_32 tx_abrt_source;
+    io_rw_32 dma_cr;
+} i2c_hw_t;
+
+typedef struct i2c_inst {
+    i2c_hw_t hw;
+    uint baudrate;
+    uint64_t bytes_written;  // host only: bytes written by the CPU, see dma.h for DMA traffic
+} i2c_inst_t;
+
+inline i2c_inst_t host_i2c[2] = {};
+
+#define i2c0 (&host_i2c[0])
+#define i2c1 (&host_i2c[1])
+
+static inline uint i2c_init(i2c_inst_t * i2c, uint baudrate) {
+    i2c->baudrate = baudrate;
+    return baudrate;
+}
+
+static inline uint i2c_hw_index(i2c_inst_t * i2c) {
+    return i2c == i2c1 ? 1 : 0;
+}
+
+static inline i2c_hw_t * i2c_get_hw(i2c_inst_t * i2c) {
+    return &i2c->hw;
+}
+
+static inline uint i2c_get_dreq(i2c_inst_t * i2c, bool is_tx) {
+    return i2c_hw_index(i2c) ? (is_tx ? DREQ_I2C1_TX : DREQ_I2C1_RX) : (is_tx ? DREQ_I2C0_TX : DREQ_I2C0_RX);
+}
+
+static inline size_t i2c_get_write_available(i2c_inst_t * i2c) {
+    return I2C_IC_TX_BUFFER_DEPTH - i2c->hw.txflr;
+}
+
+static inline int i2c_write_blocking(i2c_inst_t * i2c, uint8_t addr, const uint8_t * src, size_t len, bool nostop) {
+    i2c->bytes_written += len;
+    return int(len);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "hardware/address_mapped.h"
+
+// Emulates the lane shift, mask, cross input and base add of the SIO interpolators, which is enough
+// for address generation. PEEK is computed when read, signed results and the blend modes are not
+// modelled. BASE and PEEK are pointer sized so table addresses survive on a 64-bit host.
+
+#define SIO_INTERP0_CTRL_LANE0_SHIFT_LSB 0
+#define SIO_INTERP0_CTRL_LANE0_SHIFT_BITS 0x0000001fu
+#define SIO_INTERP0_CTRL_LANE0_MASK_LSB_LSB 5
+#define SIO_INTERP0_CTRL_LANE0_MASK_LSB_BITS 0x000003e0u
+#define SIO_INTERP0_CTRL_LANE0_MASK_MSB_LSB 10
+#define SIO_INTERP0_CTRL_LANE0_MASK_MSB_BITS 0x00007c00u
+#define SIO_INTERP0_CTRL_LANE0_CROSS_INPUT_BITS 0x00010000u
+
+typedef struct {
+    uint32_t ctrl;
+} interp_config;
+
+struct host_interp_peek {
+    uintptr_t operator[](uint lane) const;
+};
+
+typedef struct {
+    io_rw_32 accum[2];
+    volatile uintptr_t base[3];
+    host_interp_peek peek;
+    io_rw_32 ctrl[2];
+} interp_hw_t;
+
+typedef struct {
+    uint32_t accum[2];
+    uintptr_t base[3];
+    uint32_t ctrl[2];
+} interp_hw_save_t;
+
+inline interp_hw_t host_interp[2] = {};
+
+#define interp0 (&host_interp[0])
+#define interp1 (&host_interp[1])
+
+inline uintptr_t host_interp_peek::operator[](uint lane) const {
+    auto interp = (const interp_hw_t *) ((const char *) this - offsetof(interp_hw_t, peek));
+    uint32_t const ctrl = interp->ctrl[lane];
+    uint32_t const input = interp->accum[(ctrl & SIO_INTERP0_CTRL_LANE0_CROSS_INPUT_BITS) ? 1 - lane : lane];
+    uint const shift = ctrl & SIO_INTERP0_CTRL_LANE0_SHIFT_BITS;
+    uint const lsb = (ctrl & SIO_INTERP0_CTRL_LANE0_MASK_LSB_BITS) >> SIO_INTERP0_CTRL_LANE0_MASK_LSB_LSB;
+    uint const msb = (ctrl & SIO_INTERP0_CTRL_LANE0_MASK_MSB_BITS) >> SIO_INTERP0_CTRL_LANE0_MASK_MSB_LSB;
+    uint32_t const mask = (uint32_t) ((2ull << msb) - (1ull << lsb));
+    return ((input >> shift) & mask) + interp->base[lane];
+}
+
+static inline interp_config interp_default_config() {
+    return {31u << SIO_INTERP0_CTRL_LANE0_MASK_MSB_LSB};
+}
+
+static inline void interp_config_set_shift(interp_config * c, uint shift) {
+    c->ctrl = (c->ctrl & ~SIO_INTERP0_CTRL_LANE0_SHIFT_BITS) | (shift << SIO_INTERP0_CTRL_LANE0_SHIFT_LSB);
+}
+
+static inline void interp_config_set_mask(interp_config * c, uint mask_lsb, uint mask_msb) {
+    c->ctrl = (c->ctrl & ~(SIO_INTERP0_CTRL_LANE0_MASK_LSB_BITS | SIO_INTERP0_CTRL_LANE0_MASK_MSB_BITS)) |
+              (mask_lsb << SIO_INTERP0_CTRL_LANE0_MASK_LSB_LSB) | (mask_msb << SIO_INTERP0_CTRL_LANE0_MASK_MSB_LSB);
+}
+
+static inline void interp_config_set_cross_input(interp_config * c, bool cross_input) {
+    c->ctrl = cross_input ? (c->ctrl | SIO_INTERP0_CTRL_LANE0_CROSS_INPUT_BITS)
+                          : (c->ctrl & ~SIO_INTERP0_CTRL_LANE0_CROSS_INPUT_BITS);
+}
+
+static inline void interp_set_config(interp_hw_t * interp, uint lane, interp_config * config) {
+    interp->ctrl[lane] = config->ctrl;
+}
+
+static inline void interp_save(interp_hw_t * interp, interp_hw_save_t * saver) {
+    for (int i = 0; i < 2; i++) saver->accum[i] = interp->accum[i];
+    for (int i = 0; i < 3; i++) saver->base[i] = interp->base[i];
+    for (int i = 0; i < 2; i++) saver->ctrl[i] = interp->ctrl[i];
+}
+
+static inline void interp_restore(interp_hw_t * interp, interp_hw_save_t * saver) {
+    for (int i = 0; i < 2; i++) interp->accum[i] = saver->accum[i];
+    for (int i = 0; i < 3; i++) interp->base[i] = saver->base[i];
+    for (int i = 0; i < 2; i++) interp->ctrl[i] = saver->ctrl[i];
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <sys/types.h>
+
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+#define IO_IRQ_BANK0 13
+#define I2C0_IRQ 23
+#define I2C1_IRQ 24
+
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+typedef void (* irq_handler_t)();
+
+struct host_irq_state {
+    static constexpr uint max_handlers = 4;
+    irq_handler_t handlers[32][max_handlers];
+    bool enabled[32];
+};
+
+inline host_irq_state host_irq = {};
+
+static inline void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) {
+    for (auto & h: host_irq.handlers[num]) {
+        if (!h) {
+            h = handler;
+            return;
+        }
+    }
+}
+
+static inline void irq_remove_handler(uint num, irq_handler_t handler) {
+    for (auto & h: host_irq.handlers[num]) {
+        if (h == handler) h = nullptr;
+    }
+}
+
+static inline void irq_set_enabled(uint num, bool enabled) {
+    host_irq.enabled[num] = enabled;
+}
+
+static inline bool irq_is_enabled(uint num) {
+    return host_irq.enabled[num];
+}
+
+// Host only: run the handlers for `num` as if the interrupt had been raised
+static inline void host_irq_raise(uint num) {
+    if (!host_irq.enabled[num]) return;
+    for (auto h: host_irq.handlers[num]) {
+        if (h) h();
+    }
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstdint>
+#include <sys/types.h>
+
+#include "hardware/address_mapped.h"
+#include "hardware/pio_instructions.h"
+
+#define NUM_PIOS 2
+#define NUM_PIO_STATE_MACHINES 4
+#define PIO_INSTRUCTION_COUNT 32
+
+#define PIO_FDEBUG_TXSTALL_LSB 24
+
+#define DREQ_PIO0_TX0 0
+#define DREQ_PIO0_RX0 4
+#define DREQ_PIO1_TX0 8
+#define DREQ_PIO1_RX0 12
+
+typedef struct {
+    io_rw_32 ctrl;
+    io_ro_32 fstat;
+    io_rw_32 fdebug;
+    io_ro_32 flevel;
+    io_wo_32 txf[NUM_PIO_STATE_MACHINES];
+    io_ro_32 rxf[NUM_PIO_STATE_MACHINES];
+    io_wo_32 instr_mem[PIO_INSTRUCTION_COUNT];
+} pio_hw_t;
+
+// Transfers complete at once on the host, so FDEBUG always reads as stalled. Words the CPU puts
+// into a TX FIFO are counted, DMA traffic is counted by dma.h.
+struct host_pio_state {
+    pio_hw_t hw;
+    uint32_t used_instructions;
+    uint8_t claimed_sm;
+    uint64_t words_written;  // host only
+};
+
+inline host_pio_state host_pio[NUM_PIOS] = {};
+
+typedef pio_hw_t * PIO;
+
+#define pio0 (&host_pio[0].hw)
+#define pio1 (&host_pio[1].hw)
+
+typedef struct pio_program {
+    const uint16_t * instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+// the shim keeps a config but does not interpret it
+typedef struct {
+    float clkdiv;
+    uint wrap_target, wrap;
+    uint sideset_bit_count, sideset_base;
+    bool sideset_optional, sideset_pindirs;
+    uint out_base, out_count;
+    uint set_base, set_count;
+    bool out_shift_right, autopull;
+    uint pull_threshold;
+    bool in_shift_right, autopush;
+    uint push_threshold;
+    uint fifo_join;
+} pio_sm_config;
+
+enum pio_fifo_join {
+    PIO_FIFO_JOIN_NONE = 0,
+    PIO_FIFO_JOIN_TX = 1,
+    PIO_FIFO_JOIN_RX = 2,
+};
+
+static inline host_pio_state & host_pio_get(PIO pio) {
+    return pio == pio1 ? host_pio[1] : host_pio[0];
+}
+
+static inline uint pio_get_index(PIO pio) {
+    return pio == pio1 ? 1 : 0;
+}
+
+static inline uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    return (pio == pio1 ? DREQ_PIO1_TX0 : DREQ_PIO0_TX0) + sm + (is_tx ? 0 : NUM_PIO_STATE_MACHINES);
+}
+
+static inline pio_sm_config pio_get_default_sm_config() {
+    pio_sm_config c = {};
+    c.clkdiv = 1.0f;
+    c.wrap = PIO_INSTRUCTION_COUNT - 1;
+    c.out_count = 32;
+    c.out_shift_right = true;
+    c.in_shift_right = true;
+    c.pull_threshold = 32;
+    c.push_threshold = 32;
+    return c;
+}
+
+static inline void sm_config_set_out_pins(pio_sm_config * c, uint out_base, uint out_count) {
+    c->out_base = out_base;
+    c->out_count = out_count;
+}
+
+static inline void sm_config_set_set_pins(pio_sm_config * c, uint set_base, uint set_count) {
+    c->set_base = set_base;
+    c->set_count = set_count;
+}
+
+static inline void sm_config_set_sideset_pins(pio_sm_config * c, uint sideset_base) {
+    c->sideset_base = sideset_base;
+}
+
+static inline void sm_config_set_sideset(pio_sm_config * c, uint bit_count, bool optional, bool pindirs) {
+    c->sideset_bit_count = bit_count;
+    c->sideset_optional = optional;
+    c->sideset_pindirs = pindirs;
+}
+
+static inline void sm_config_set_clkdiv(pio_sm_config * c, float div) {
+    c->clkdiv = div;
+}
+
+static inline void sm_config_set_wrap(pio_sm_config * c, uint wrap_target, uint wrap) {
+    c->wrap_target = wrap_target;
+    c->wrap = wrap;
+}
+
+static inline void sm_config_set_out_shift(pio_sm_config * c, bool shift_right, bool autopull, uint pull_threshold) {
+    c->out_shift_right = shift_right;
+    c->autopull = autopull;
+    c->pull_threshold = pull_threshold;
+}
+
+static inline void sm_config_set_in_shift(pio_sm_config * c, bool shift_right, bool autopush, uint push_threshold) {
+    c->in_shift_right = shift_right;
+    c->autopush = autopush;
+    c->push_threshold = push_threshold;
+}
+
+static inline void sm_config_set_fifo_join(pio_sm_config * c, pio_fifo_join join) {
+    c->fifo_join = join;
+}
+
+static inline bool pio_can_add_program(PIO pio, const pio_program_t * program) {
+    uint32_t const mask = (1u << program->length) - 1;
+    for (uint offset = 0; offset + program->length <= PIO_INSTRUCTION_COUNT; offset++) {
+        if (!(host_pio_get(pio).used_instructions & (mask << offset))) return true;
+    }
+    return false;
+}
+
+// loads the program at the first free offset, relocating its JMPs like the SDK does
+static inline uint pio_add_program(PIO pio, const pio_program_t * program) {
+    host_pio_state & state = host_pio_get(pio);
+    uint32_t const mask = (1u << program->length) - 1;
+    uint offset = 0;
+    while (state.used_instructions & (mask << offset)) offset++;
+
+    for (uint i = 0; i < program->length; i++) {
+        uint16_t instr = program->instructions[i];
+        if ((instr & 0xe000) == pio_instr_bits_jmp) instr += offset;
+        pio->instr_mem[offset + i] = instr;
+    }
+    state.used_instructions |= mask << offset;
+    return offset;
+}
+
+static inline void pio_remove_program(PIO pio, const pio_program_t * program, uint loaded_offset) {
+    host_pio_get(pio).used_instructions &= ~(((1u << program->length) - 1) << loaded_offset);
+}
+
+static inline int pio_claim_unused_sm(PIO pio, bool required) {
+    host_pio_state & state = host_pio_get(pio);
+    for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+        if (!(state.claimed_sm & (1u << sm))) {
+            state.claimed_sm |= 1u << sm;
+            return sm;
+        }
+    }
+    return -1;
+}
+
+static inline void pio_sm_unclaim(PIO pio, uint sm) {
+    host_pio_get(pio).claimed_sm &= ~(1u << sm);
+}
+
+static inline void pio_gpio_init(PIO pio, uint pin) {}
+
+static inline void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out) {}
+
+static inline void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values, uint32_t pin_mask) {}
+
+static inline void pio_sm_set_pindirs_with_mask(PIO pio, uint sm, uint32_t pin_dirs, uint32_t pin_mask) {}
+
+static inline void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config * config) {
+    pio->fdebug = 0xffffffffu;
+}
+
+static inline void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {}
+
+static inline void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) {
+    pio->txf[sm] = data;
+    host_pio_get(pio).words_written++;
+}
+
+static inline bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm) {
+    return true;
+}
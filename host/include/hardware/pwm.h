@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <sys/types.h>
+
+typedef struct {
+    uint32_t csr;
+    uint32_t div;
+    uint32_t top;
+} pwm_config;
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) {
+    return (gpio >> 1u) & 7u;
+}
+
+static inline pwm_config pwm_get_default_config() {
+    return {0, 1u << 4, 0xffff};
+}
+
+static inline void pwm_init(uint slice_num, pwm_config * c, bool start) {}
+
+static inline void pwm_set_wrap(uint slice_num, uint16_t wrap) {}
+
+static inline void pwm_set_gpio_level(uint gpio, uint16_t level) {}
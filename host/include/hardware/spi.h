@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "hardware/address_mapped.h"
+
+#define SPI_SSPCR0_SCR_BITS 0x0000ff00
+
+#define DREQ_SPI0_TX 16
+#define DREQ_SPI0_RX 17
+#define DREQ_SPI1_TX 18
+#define DREQ_SPI1_RX 19
+
+typedef struct {
+    io_rw_32 cr0;
+    io_rw_32 cr1;
+    io_rw_32 dr;
+    io_rw_32 sr;
+    io_rw_32 cpsr;
+    io_rw_32 imsc;
+    io_rw_32 ris;
+    io_rw_32 mis;
+    io_rw_32 icr;
+    io_rw_32 dmacr;
+} spi_hw_t;
+
+typedef struct spi_inst {
+    spi_hw_t hw;
+    uint baudrate;
+    uint64_t bytes_written;  // host only: bytes pushed by the CPU, see dma.h for DMA traffic
+} spi_inst_t;
+
+inline spi_inst_t host_spi[2] = {};
+
+#define spi0 (&host_spi[0])
+#define spi1 (&host_spi[1])
+
+typedef enum {
+    SPI_CPHA_0 = 0,
+    SPI_CPHA_1 = 1
+} spi_cpha_t;
+
+typedef enum {
+    SPI_CPOL_0 = 0,
+    SPI_CPOL_1 = 1
+} spi_cpol_t;
+
+typedef enum {
+    SPI_LSB_FIRST = 0,
+    SPI_MSB_FIRST = 1
+} spi_order_t;
+
+static inline spi_hw_t * spi_get_hw(spi_inst_t * spi) {
+    return &spi->hw;
+}
+
+static inline uint spi_get_index(const spi_inst_t * spi) {
+    return spi == spi1 ? 1 : 0;
+}
+
+static inline uint spi_init(spi_inst_t * spi, uint baudrate) {
+    spi->baudrate = baudrate;
+    return baudrate;
+}
+
+static inline uint spi_set_baudrate(spi_inst_t * spi, uint baudrate) {
+    spi->baudrate = baudrate;
+    return baudrate;
+}
+
+static inline uint spi_get_baudrate(const spi_inst_t * spi) {
+    return spi->baudrate;
+}
+
+static inline void spi_set_format(spi_inst_t * spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha,
+                                  spi_order_t order) {}
+
+static inline bool spi_is_busy(const spi_inst_t * spi) {
+    return false;
+}
+
+static inline uint spi_get_dreq(spi_inst_t * spi, bool is_tx) {
+    return spi_get_index(spi) ? (is_tx ? DREQ_SPI1_TX : DREQ_SPI1_RX) : (is_tx ? DREQ_SPI0_TX : DREQ_SPI0_RX);
+}
+
+static inline int spi_write_blocking(spi_inst_t * spi, const uint8_t * src, size_t len) {
+    spi->bytes_written += len;
+    return int(len);
+}
+
+static inline int spi_write16_blocking(spi_inst_t * spi, const uint16_t * src, size_t len) {
+    spi->bytes_written += len * 2;
+    return int(len);
+}
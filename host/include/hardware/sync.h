@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+static inline void __wfe() {}
+
+static inline void __sev() {}
+
+static inline void __dmb() {}
+
+static inline uint32_t save_and_disable_interrupts() { return 0; }
+
+static inline void restore_interrupts(uint32_t status) {}
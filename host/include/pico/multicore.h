@@ -0,0 +1,69 @@
+#pragma once
+
+// core1 is a host thread, and the inter-core FIFOs are unbounded queues in each direction
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+struct host_fifo {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<uint32_t> data;
+
+    void push(uint32_t value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            data.push_back(value);
+        }
+        cv.notify_all();
+    }
+
+    uint32_t pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return !data.empty(); });
+        uint32_t const value = data.front();
+        data.pop_front();
+        return value;
+    }
+
+    bool empty() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return data.empty();
+    }
+};
+
+inline host_fifo host_fifo_to_core1;
+inline host_fifo host_fifo_to_core0;
+inline std::thread host_core1;
+inline thread_local bool host_on_core1 = false;
+
+static inline uint get_core_num() {
+    return host_on_core1 ? 1 : 0;
+}
+
+static inline void multicore_launch_core1(void (* entry)()) {
+    host_core1 = std::thread([entry] {
+        host_on_core1 = true;
+        entry();
+    });
+}
+
+static inline void multicore_reset_core1() {
+    // core1 can't be stopped from outside on the host, the entry function has to return
+    if (host_core1.joinable()) host_core1.join();
+}
+
+static inline void multicore_fifo_push_blocking(uint32_t data) {
+    (get_core_num() ? host_fifo_to_core0 : host_fifo_to_core1).push(data);
+}
+
+static inline uint32_t multicore_fifo_pop_blocking() {
+    return (get_core_num() ? host_fifo_to_core1 : host_fifo_to_core0).pop();
+}
+
+static inline bool multicore_fifo_rvalid() {
+    return !(get_core_num() ? host_fifo_to_core1 : host_fifo_to_core0).empty();
+}
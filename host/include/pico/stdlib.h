@@ -0,0 +1,48 @@
+#pragma once
+
+// Host-side stand-in for the parts of the Pico SDK used by this project. Only enough is provided to
+// build, benchmark and exercise the code on a desktop machine: peripherals keep a little state so
+// transfers can be counted, DMA completes immediately and interrupts only fire when host code
+// raises them (see host_irq_raise() and host_gpio_trigger()).
+
+#include <chrono>
+#include <cstdint>
+#include <sys/types.h>
+#include <thread>
+
+#include "hardware/gpio.h"
+
+#define PICO_ON_DEVICE 0
+
+#define __isr
+#define __not_in_flash_func(func_name) func_name
+
+typedef uint64_t absolute_time_t;
+
+static inline uint64_t time_us_64() {
+    using namespace std::chrono;
+    static auto const boot = steady_clock::now();
+    return duration_cast<microseconds>(steady_clock::now() - boot).count();
+}
+
+static inline uint32_t time_us_32() {
+    return static_cast<uint32_t>(time_us_64());
+}
+
+static inline absolute_time_t get_absolute_time() {
+    return time_us_64();
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return static_cast<uint32_t>(t / 1000);
+}
+
+static inline void sleep_us(uint64_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+static inline void sleep_ms(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static inline void tight_loop_contents() {}
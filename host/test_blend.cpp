@@ -0,0 +1,112 @@
+// The two-pixels-per-word RGB565 blends against a pixel and channel at a time reference, and
+// blended drawing on the display list against drawing straight to RGB565.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "ST7789VW/pico_graphics.hpp"
+#include "test_common.hpp"
+
+namespace {
+
+    // Blends one byte swapped RGB565 pixel a channel at a time, with the same alpha quantisation as
+    // PicoGraphics_PenRGB565::blend_span()
+    uint16_t reference_blend(uint16_t dst, uint16_t src, int alpha, PicoGraphics::BlendMode mode) {
+        int const d = __builtin_bswap16(dst);
+        int const s = __builtin_bswap16(src);
+        int const dc[3] = {d >> 11, (d >> 5) & 63, d & 31};
+        int const sc[3] = {s >> 11, (s >> 5) & 63, s & 31};
+        int const max[3] = {31, 63, 31};
+        int out[3];
+        for (int i = 0; i < 3; i++) {
+            if (mode == PicoGraphics::BLEND_NORMAL) {
+                int const a = (alpha + 4) >> 3;
+                out[i] = a == 32 ? sc[i] : (sc[i] * a + dc[i] * (32 - a)) >> 5;
+            } else if (mode == PicoGraphics::BLEND_ADD) {
+                int const a = (alpha + 4) >> 3;
+                out[i] = std::min(max[i], dc[i] + ((sc[i] * a) >> 5));
+            } else {
+                int const a = alpha + (alpha >> 7);
+                int const factor = (sc[i] * a + max[i] * (256 - a)) / max[i];
+                out[i] = (dc[i] * factor) >> 8;
+            }
+        }
+        return __builtin_bswap16(uint16_t(out[0] << 11 | out[1] << 5 | out[2]));
+    }
+
+    // Spans at every start and length in a row, so every alignment and both lone pixel ends are
+    // covered, with the rest of the buffer checked untouched
+    void test_spans() {
+        int const w = 40, h = 3;
+        static uint16_t buffer[w * h], initial[w * h];
+        PicoGraphics_PenRGB565 graphics(w, h, buffer);
+
+        PicoGraphics::BlendMode const modes[] = {PicoGraphics::BLEND_NORMAL, PicoGraphics::BLEND_ADD,
+                                                 PicoGraphics::BLEND_MULTIPLY};
+        for (auto mode: modes) {
+            for (int alpha: {0, 1, 7, 100, 128, 200, 254, 255}) {
+                for (int x = 0; x < w; x++) {
+                    for (int l = 0; x + l <= w; l++) {
+                        for (auto & v: initial) v = rand();
+                        memcpy(buffer, initial, sizeof(buffer));
+                        uint16_t const colour = rand();
+                        graphics.set_pen(colour);
+                        graphics.set_blend(alpha, mode);
+                        graphics.set_pixel_span(Point(x, 1), l);
+
+                        int bad = 0;
+                        for (int i = 0; i < w * h; i++) {
+                            int const px = i % w, py = i / w;
+                            bool const inside = py == 1 && px >= x && px < x + l;
+                            bad += buffer[i] != (inside ? reference_blend(initial[i], colour, alpha, mode) : initial[i]);
+                        }
+                        CHECK(bad == 0, "mode %d alpha %d span %d + %d: %d pixels differ", mode, alpha, x, l, bad);
+                    }
+                }
+            }
+        }
+    }
+
+    // Blended primitives recorded on the display list come out as drawn straight to RGB565
+    void test_display_list() {
+        int const w = 160, h = 120;
+        static uint16_t direct_buffer[w * h], replayed[w * h];
+        PicoGraphics_PenRGB565 direct(w, h, direct_buffer);
+        PicoGraphics_PenDisplayList list(w, h, 16);
+
+        for (PicoGraphics * g: {(PicoGraphics *) &direct, (PicoGraphics *) &list}) {
+            srand(9);
+            g->set_pen(0x1234);
+            g->clear();
+            for (int i = 0; i < 200; i++) {
+                g->set_blend(rand() % 256, PicoGraphics::BlendMode(rand() % 3));
+                g->set_pen(rand() & 0xffff);
+                Point const p(rand() % w, rand() % h);
+                switch (rand() % 4) {
+                    case 0: g->rectangle(Rect(p.x - 20, p.y - 15, rand() % 50, rand() % 40)); break;
+                    case 1: g->circle(p, rand() % 25); break;
+                    case 2: g->line_aa(p, Point(rand() % w, rand() % h)); break;
+                    default: g->triangle(p, Point(rand() % w, rand() % h), Point(rand() % w, rand() % h)); break;
+                }
+            }
+        }
+
+        size_t offset = 0;
+        list.frame_convert(PicoGraphics::PEN_RGB565, [&offset](void * data, size_t length) {
+            memcpy((uint8_t *) replayed + offset, data, length);
+            offset += length;
+        });
+        CHECK(offset == sizeof(replayed) && memcmp(direct_buffer, replayed, sizeof(replayed)) == 0,
+              "display list differs from drawing straight to RGB565");
+    }
+
+}
+
+int main() {
+    srand(1);
+    test_spans();
+    test_display_list();
+
+    return test_result();
+}
@@ -0,0 +1,211 @@
+// PicoGraphics::blit() on every pen against a pixel at a time reference, and the colours it picks
+// on the palette and 1 bit pens.
+
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "ST7789VW/pico_graphics.hpp"
+#include "test_common.hpp"
+
+namespace {
+
+    typedef PicoGraphics::Bitmap Bitmap;
+
+    RGB palette[256];
+
+    uint32_t source_pixel(const Bitmap & b, int32_t x, int32_t y) {
+        const uint8_t * row = (const uint8_t *) b.data + y * b.stride;
+        switch (b.format) {
+            case PicoGraphics::PEN_1BIT:
+                return (row[x / 8] >> (7 - x % 8)) & 1;
+            case PicoGraphics::PEN_P4:
+                return x % 2 ? row[x / 2] & 0xf : row[x / 2] >> 4;
+            case PicoGraphics::PEN_RGB565:
+                return ((const uint16_t *) row)[x];
+            case PicoGraphics::PEN_RGB888:
+                return ((const uint32_t *) row)[x];
+            default:
+                return row[x];
+        }
+    }
+
+    // Every covered destination pixel found from its source pixel by division, drawn with pixel()
+    void reference_blit(PicoGraphics & g, const Bitmap & b, const Rect & src, const Point & dest, int32_t scale) {
+        PicoGraphics::PenType native = g.pen_type == PicoGraphics::PEN_DISPLAY_LIST ? PicoGraphics::PEN_RGB565 : g.pen_type;
+        for (int32_t y = 0; y < src.h * scale; y++) {
+            for (int32_t x = 0; x < src.w * scale; x++) {
+                int32_t const sx = src.x + x / scale;
+                int32_t const sy = src.y + y / scale;
+                if (sx < 0 || sy < 0 || sx >= b.width || sy >= b.height) continue;
+                if (b.mask && !(b.mask[sy * b.mask_stride + sx / 8] & (0x80 >> (sx % 8)))) continue;
+
+                uint32_t const v = source_pixel(b, sx, sy);
+                if (int32_t(v) == b.transparent) continue;
+
+                if (b.format == native && native != PicoGraphics::PEN_1BIT) {
+                    g.set_pen(v);
+                } else {
+                    RGB c;
+                    switch (b.format) {
+                        case PicoGraphics::PEN_1BIT: c = v ? RGB(255, 255, 255) : RGB(0, 0, 0); break;
+                        case PicoGraphics::PEN_P4:
+                        case PicoGraphics::PEN_P8: c = b.palette[v]; break;
+                        case PicoGraphics::PEN_RGB332: c = RGB(RGB332(v)); break;
+                        case PicoGraphics::PEN_RGB565: c = RGB(RGB565(v)); break;
+                        default: c = RGB((v >> 16) & 0xff, (v >> 8) & 0xff, v & 0xff); break;
+                    }
+                    g.set_pen(c.r, c.g, c.b);
+                }
+                g.pixel(Point(dest.x + x, dest.y + y));
+            }
+        }
+    }
+
+    template<typename Pen>
+    std::vector<uint8_t> contents(Pen & g) {
+        std::vector<uint8_t> out;
+        if constexpr (std::is_same_v<Pen, PicoGraphics_PenDisplayList>) {
+            g.frame_convert(PicoGraphics::PEN_RGB565, [&out](void * data, size_t length) {
+                out.insert(out.end(), (uint8_t *) data, (uint8_t *) data + length);
+            });
+        } else {
+            out.assign((uint8_t *) g.frame_buffer, (uint8_t *) g.frame_buffer + Pen::buffer_size(g.bounds.w, g.bounds.h));
+        }
+        return out;
+    }
+
+    template<typename Pen>
+    void setup_palette(Pen & g) {
+        if constexpr (std::is_same_v<Pen, PicoGraphics_PenP4> || std::is_same_v<Pen, PicoGraphics_PenP8>) {
+            for (uint i = 0; i < Pen::palette_size; i++) g.update_pen(i, palette[i].r, palette[i].g, palette[i].b);
+        }
+    }
+
+    template<typename Pen>
+    Pen make_pen(int32_t w, int32_t h) {
+        if constexpr (std::is_same_v<Pen, PicoGraphics_PenDisplayList>) {
+            return Pen(w, h, 16);
+        } else {
+            return Pen(w, h, nullptr);
+        }
+    }
+
+    // Blits of a random bitmap with keys, masks, scales, strides and clipping
+    template<typename Pen>
+    void test_against_reference(const char * name, PicoGraphics::PenType format) {
+        int const bits = format == PicoGraphics::PEN_1BIT ? 1 : format == PicoGraphics::PEN_P4 ? 4 :
+                         format == PicoGraphics::PEN_RGB565 ? 16 : format == PicoGraphics::PEN_RGB888 ? 32 : 8;
+        uint16_t const w = 37, h = 23;
+        uint32_t const stride = ((w * bits + 7) / 8 + 8) & ~3u;  // padded past the end of the row
+
+        std::vector<uint8_t> data(stride * h);
+        for (auto & v: data) v = rand() % 3 ? rand() : 0;
+        if (format == PicoGraphics::PEN_RGB888) {
+            for (uint32_t i = 0; i < data.size(); i += 4) data[i + 3] = 0;
+        }
+        std::vector<uint8_t> mask(6 * h);
+        for (auto & v: mask) v = rand() | rand();
+
+        Pen blitted = make_pen<Pen>(160, 120);
+        Pen reference = make_pen<Pen>(160, 120);
+        for (Pen * g: {&blitted, &reference}) {
+            setup_palette(*g);
+            g->set_pen(0);
+            g->clear();
+            g->set_clip(Rect(7, 5, 140, 100));
+        }
+
+        for (int i = 0; i < 200; i++) {
+            Bitmap bitmap{format, data.data(), w, h, stride, palette};
+            if (i % 3 == 1) bitmap.transparent = source_pixel(bitmap, rand() % w, rand() % h);
+            if (i % 3 == 2) {
+                bitmap.mask = mask.data();
+                bitmap.mask_stride = 6;
+            }
+            Rect const src(rand() % (w + 10) - 5, rand() % (h + 10) - 5, rand() % 30, rand() % 20);
+            Point const dest(rand() % 200 - 30, rand() % 160 - 30);
+            int32_t const scale = 1 + rand() % 4;
+
+            blitted.blit(bitmap, src, dest, scale);
+            reference_blit(reference, bitmap, src, dest, scale);
+        }
+
+        CHECK(contents(blitted) == contents(reference), "%s from format %d differs from the reference", name, format);
+    }
+
+    // Each colour must draw as its pen, which is what drawing with set_pen(pen) gives
+    template<typename Pen>
+    void test_pen_colours(const char * name, const RGB * colours, const uint * pens, uint count) {
+        for (uint i = 0; i < count; i++) {
+            Pen blitted = make_pen<Pen>(16, 8);
+            Pen expected = make_pen<Pen>(16, 8);
+            for (Pen * g: {&blitted, &expected}) {
+                setup_palette(*g);
+                g->set_pen(pens[(i + 1) % count]);
+                g->clear();
+            }
+
+            RGB888 const c = RGB(colours[i]).to_rgb888();
+            blitted.blit(Bitmap{PicoGraphics::PEN_RGB888, &c, 1, 1, 4}, Rect(0, 0, 1, 1), Point(4, 0), 8);
+            expected.set_pen(pens[i]);
+            expected.rectangle(Rect(4, 0, 8, 8));
+
+            CHECK(contents(blitted) == contents(expected), "%s colour %d not drawn as pen %d", name, i, pens[i]);
+        }
+    }
+
+    template<typename Pen>
+    void test_pen(const char * name) {
+        PicoGraphics::PenType const formats[] = {
+                PicoGraphics::PEN_1BIT, PicoGraphics::PEN_P4, PicoGraphics::PEN_P8,
+                PicoGraphics::PEN_RGB332, PicoGraphics::PEN_RGB565, PicoGraphics::PEN_RGB888,
+        };
+        for (auto format: formats) test_against_reference<Pen>(name, format);
+    }
+
+}
+
+int main() {
+    srand(1);
+    for (auto & c: palette) c = RGB(rand() & 0xff, rand() & 0xff, rand() & 0xff);
+
+    test_pen<PicoGraphics_Pen1Bit>("1bit");
+    test_pen<PicoGraphics_Pen1BitY>("1bitY");
+    test_pen<PicoGraphics_Pen3Bit>("3bit");
+    test_pen<PicoGraphics_PenP4>("P4");
+    test_pen<PicoGraphics_PenP8>("P8");
+    test_pen<PicoGraphics_PenRGB332>("RGB332");
+    test_pen<PicoGraphics_PenRGB565>("RGB565");
+    test_pen<PicoGraphics_PenRGB888>("RGB888");
+    test_pen<PicoGraphics_PenDisplayList>("display list");
+
+    uint pens[16];
+    for (uint i = 0; i < 16; i++) pens[i] = i;
+    PicoGraphics_Pen3Bit pen3(8, 8, nullptr);
+    test_pen_colours<PicoGraphics_Pen3Bit>("3bit", pen3.palette, pens, PicoGraphics_Pen3Bit::palette_size);
+    test_pen_colours<PicoGraphics_PenP4>("P4", palette, pens, PicoGraphics_PenP4::palette_size);
+    test_pen_colours<PicoGraphics_PenP8>("P8", palette, pens, 16);  // set_pen(r, g, b) matches the first 16
+
+    // the 1 bit pens take a dither level, black and white are pens 0 and 15
+    RGB const mono[2] = {RGB(0, 0, 0), RGB(255, 255, 255)};
+    uint const mono_pens[2] = {0, 15};
+    test_pen_colours<PicoGraphics_Pen1Bit>("1bit", mono, mono_pens, 2);
+    test_pen_colours<PicoGraphics_Pen1BitY>("1bitY", mono, mono_pens, 2);
+
+    // sprite() draws its 8x8 tile through blit() on every pen
+    static uint8_t sheet[128 * 128];
+    for (auto & v: sheet) v = rand();
+    PicoGraphics_Pen3Bit sprite3(16, 16, nullptr);
+    sprite3.set_pen(0);
+    sprite3.clear();
+    sprite3.sprite(sheet, Point(1, 2), Point(4, 4), 1, -1);
+    PicoGraphics_Pen3Bit expected3(16, 16, nullptr);
+    expected3.set_pen(0);
+    expected3.clear();
+    reference_blit(expected3, Bitmap{PicoGraphics::PEN_RGB332, sheet, 128, 128, 128}, Rect(8, 16, 8, 8), Point(4, 4), 1);
+    CHECK(contents(sprite3) == contents(expected3), "3bit sprite differs from the reference");
+
+    return test_result();
+}
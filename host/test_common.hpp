@@ -0,0 +1,23 @@
+#pragma once
+
+// Minimal checks for the host tests. A failed CHECK prints where and why, and the test returns
+// test_result() from main so ctest sees the failure.
+
+#include <cstdio>
+
+inline int test_failures = 0;
+
+#define CHECK(cond, ...)                                         \
+    do {                                                         \
+        if (!(cond)) {                                           \
+            test_failures++;                                     \
+            printf("%s:%d: %s: ", __FILE__, __LINE__, #cond);    \
+            printf(__VA_ARGS__);                                 \
+            printf("\n");                                        \
+        }                                                        \
+    } while (0)
+
+inline int test_result() {
+    if (test_failures) printf("%d checks failed\n", test_failures);
+    return test_failures ? 1 : 0;
+}
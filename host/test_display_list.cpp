@@ -0,0 +1,157 @@
+// The display list replayed band by band against the same drawing straight to RGB565.
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ST7789VW/pico_graphics.hpp"
+#include "test_common.hpp"
+
+namespace {
+
+    int const W = 160, H = 120;
+
+    // Draws the same frame on an RGB565 pen and a display list and compares the two
+    class Pair {
+    public:
+        PicoGraphics_PenRGB565 direct{W, H, nullptr};
+        PicoGraphics_PenDisplayList list{W, H, 16};
+
+        template<typename F>
+        void draw(F f) {
+            f(static_cast<PicoGraphics &>(direct));
+            f(static_cast<PicoGraphics &>(list));
+        }
+
+        bool same() {
+            std::vector<uint8_t> replayed;
+            list.frame_convert(PicoGraphics::PEN_RGB565, [&replayed](void * data, size_t length) {
+                replayed.insert(replayed.end(), (uint8_t *) data, (uint8_t *) data + length);
+            });
+            return replayed.size() == W * H * sizeof(RGB565) &&
+                   memcmp(replayed.data(), direct.frame_buffer, replayed.size()) == 0;
+        }
+    };
+
+    // Text long enough to push the text pool past what 16 bits can index, drawn under a clip so the
+    // clear() in between doesn't reset the pools
+    void test_large_text_pool() {
+        Pair pair;
+        pair.draw([](PicoGraphics & g) {
+            g.set_pen(0);
+            g.clear();
+            g.set_pen(0xffff);
+            g.set_clip(Rect(0, 0, W, 8));
+            std::string const line(200, 'x');
+            for (int i = 0; i < 250; i++) {
+                g.text(line, Point(-i, 0), W, 1);
+                if (i % 50 == 0) g.clear();
+            }
+            g.remove_clip();
+            g.set_pen(0xf800);
+            g.text("pool past 32767", Point(4, 60), W, 2);
+        });
+        CHECK(pair.list.strings.size() > 40000, "text pool only %d characters", int(pair.list.strings.size()));
+        CHECK(pair.same(), "text after a 16 bit text pool differs");
+    }
+
+    // Polygons enough to push the point pool past what 16 bits can index
+    void test_large_point_pool() {
+        Pair pair;
+        pair.draw([](PicoGraphics & g) {
+            g.set_pen(0);
+            g.clear();
+            g.set_clip(Rect(0, 0, W, 8));
+            std::vector<Point> ring;
+            for (int i = 0; i < 400; i++) ring.push_back(Point(i % 2 ? 3 : W - 3, i % 8));
+            for (int i = 0; i < 120; i++) {
+                g.set_pen(i * 517);
+                g.polygon(ring);
+            }
+            g.remove_clip();
+            g.set_pen(0x07e0);
+            g.polygon({{Point(10, 20), Point(150, 30), Point(80, 110)}, {Point(60, 50), Point(90, 50), Point(75, 80)}},
+                      PicoGraphics::FILL_NON_ZERO);
+        });
+        CHECK(pair.list.points.size() > 40000, "point pool only %d points", int(pair.list.points.size()));
+        CHECK(pair.same(), "polygon after a 16 bit point pool differs");
+    }
+
+    // Rectangles and spans reaching far past the screen, where their sizes don't fit 16 bits
+    void test_large_coordinates() {
+        Pair pair;
+        pair.draw([](PicoGraphics & g) {
+            g.set_pen(0x1234);
+            g.clear();
+            g.set_blend(100);
+            g.set_pen(0xffff);
+            g.rectangle(Rect(-100000, 10, 200000, 20));
+            g.pixel_span(Point(-50000, 50), 100000);
+            Rect const column(5, -70000, 3, 140000);
+            g.rectangles(&column, 1);
+        });
+        CHECK(pair.same(), "primitives past 16 bit coordinates differ");
+    }
+
+    // Every recorded primitive, under changing clips and blends, must replay byte for byte
+    void test_mixed(unsigned seed) {
+        static uint8_t sheet[32 * 32];
+        for (auto & v: sheet) v = rand();
+
+        Pair pair;
+        pair.draw([seed](PicoGraphics & g) {
+            srand(seed);
+            g.set_pen(0x4208);
+            g.clear();
+            for (int i = 0; i < 400; i++) {
+                g.set_pen(rand() & 0xffff);
+                if (i % 37 == 0) g.set_clip(Rect(rand() % W - 20, rand() % H - 20, rand() % W + 40, rand() % H + 40));
+                if (i % 53 == 0) g.remove_clip();
+                if (i % 29 == 0) g.set_blend(rand() % 256, PicoGraphics::BlendMode(rand() % 3));
+                Point const p(rand() % (W + 40) - 20, rand() % (H + 40) - 20);
+                Point const q(rand() % (W + 40) - 20, rand() % (H + 40) - 20);
+                Point const r(rand() % (W + 40) - 20, rand() % (H + 40) - 20);
+                switch (rand() % 14) {
+                    case 0: g.pixel(p); break;
+                    case 1: g.pixel_span(p, rand() % 60); break;
+                    case 2: g.rectangle(Rect(p.x, p.y, rand() % 50, rand() % 50)); break;
+                    case 3: g.circle(p, rand() % 30); break;
+                    case 4: g.text("Hello", p, 60, 1 + rand() % 2); break;
+                    case 5: g.polygon({p, q, r, Point(p.x, q.y)}); break;
+                    case 6: g.polygon({{p, q, r}, {q, r, Point(p.x, r.y)}}, PicoGraphics::FillRule(rand() % 2)); break;
+                    case 7: g.triangle(p, q, r); break;
+                    case 8: g.line(p, q); break;
+                    case 9: g.line_aa(p, q); break;
+                    case 10: g.circle_outline_aa(p, rand() % 30); break;
+                    case 11: g.polyline({p, q, r}, 1 + rand() % 6); break;
+                    case 12: {
+                        // several contours of any size, crossing themselves and each other
+                        std::vector<std::vector<Point>> contours(1 + rand() % 3);
+                        for (auto & points: contours) {
+                            points.resize(rand() % 10);
+                            for (auto & v: points) v = Point(p.x + rand() % 81 - 40, p.y + rand() % 81 - 40);
+                        }
+                        g.polygon(contours, PicoGraphics::FillRule(rand() % 2));
+                        break;
+                    }
+                    default:
+                        g.blit(PicoGraphics::Bitmap{PicoGraphics::PEN_RGB332, sheet, 32, 32, 32},
+                               Rect(rand() % 16, rand() % 16, 16, 16), p, 1 + rand() % 2);
+                        break;
+                }
+            }
+        });
+        CHECK(pair.same(), "mixed primitives from seed %u differ", seed);
+    }
+
+}
+
+int main() {
+    test_large_text_pool();
+    test_large_point_pool();
+    test_large_coordinates();
+    for (unsigned seed = 1; seed <= 20; seed++) test_mixed(seed);
+
+    return test_result();
+}
@@ -0,0 +1,108 @@
+// PicoGraphics::polygon() against a pixel at a time crossing test, on random self intersecting
+// shapes of several contours, under both fill rules, clipped and not. Half are drawn additively
+// blended, where a pixel drawn twice shows.
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "ST7789VW/pico_graphics.hpp"
+#include "test_common.hpp"
+
+namespace {
+
+    uint16_t const WIDTH = 96, HEIGHT = 64;
+
+    int64_t floor_div(int64_t n, int64_t d) {
+        return n >= 0 ? n / d : -((-n + d - 1) / d);
+    }
+
+    // A pixel is sampled where each edge crosses its row, which edges below their top row do, at the
+    // x rounded down. Each crossing is covered, as is every pixel past an odd number of crossings,
+    // or past crossings that don't wind to zero.
+    void reference_polygon(PicoGraphics & g, const std::vector<std::vector<Point>> & contours,
+                           PicoGraphics::FillRule rule) {
+        for (int32_t y = 0; y < HEIGHT; y++) {
+            for (int32_t x = 0; x < WIDTH; x++) {
+                int32_t before = 0;   // crossings left of the pixel
+                int32_t winding = 0;  // and how they wind
+                bool on = false;
+
+                for (auto & points: contours) {
+                    for (size_t i = 0; i < points.size(); i++) {
+                        const Point & p = points[i];
+                        const Point & q = points[(i + 1) % points.size()];
+                        const Point & top = p.y < q.y ? p : q;
+                        const Point & bottom = p.y < q.y ? q : p;
+                        if (y <= top.y || y > bottom.y) continue;
+
+                        int64_t const cx = top.x + floor_div(int64_t(bottom.x - top.x) * (y - top.y), bottom.y - top.y);
+                        if (cx == x) on = true;
+                        if (cx < x) {
+                            before++;
+                            winding += p.y < q.y ? 1 : -1;
+                        }
+                    }
+                }
+
+                bool const inside = rule == PicoGraphics::FILL_EVEN_ODD ? before % 2 == 1 : winding != 0;
+                if (on || inside) g.pixel(Point(x, y));
+            }
+        }
+    }
+
+    std::vector<std::vector<Point>> random_shape() {
+        std::vector<std::vector<Point>> contours(1 + rand() % 4);
+        for (auto & points: contours) {
+            // a few long contours cross the whole frame, most stay near a centre
+            int32_t const spread = rand() % 4 ? 24 : 80;
+            Point const centre(rand() % WIDTH, rand() % HEIGHT);
+            points.resize(rand() % 12);
+            for (auto & p: points) {
+                p = Point(centre.x + rand() % (2 * spread + 1) - spread, centre.y + rand() % (2 * spread + 1) - spread);
+            }
+        }
+        return contours;
+    }
+
+}
+
+int main() {
+    srand(1);
+
+    PicoGraphics_PenRGB565 filled(WIDTH, HEIGHT, nullptr);
+    PicoGraphics_PenRGB565 reference(WIDTH, HEIGHT, nullptr);
+    size_t const size = PicoGraphics_PenRGB565::buffer_size(WIDTH, HEIGHT);
+
+    int failures = 0;
+    for (int i = 0; i < 5000 && failures < 10; i++) {
+        std::vector<std::vector<Point>> const contours = random_shape();
+        PicoGraphics::FillRule const rule = i % 2 ? PicoGraphics::FILL_NON_ZERO : PicoGraphics::FILL_EVEN_ODD;
+        Rect const clip = i % 4 >= 2 ? Rect(rand() % 30, rand() % 20, 10 + rand() % 60, 8 + rand() % 40)
+                                     : Rect(0, 0, WIDTH, HEIGHT);
+
+        for (PicoGraphics * g: {(PicoGraphics *) &filled, (PicoGraphics *) &reference}) {
+            g->remove_clip();
+            g->set_blend(255);
+            g->set_pen(0);
+            g->clear();
+            g->set_clip(clip);
+            g->set_pen(0xffff);
+            if (i % 4 == 1 || i % 4 == 2) g->set_blend(64, PicoGraphics::BLEND_ADD);
+        }
+        if (contours.size() == 1 && i % 3 == 0) {
+            filled.polygon(contours[0]);
+        } else {
+            filled.polygon(contours, rule);
+        }
+        reference_polygon(reference, contours,
+                          contours.size() == 1 && i % 3 == 0 ? PicoGraphics::FILL_EVEN_ODD : rule);
+
+        if (memcmp(filled.frame_buffer, reference.frame_buffer, size) != 0) {
+            failures++;
+            CHECK(false, "shape %d of %d contours, rule %d, differs from the reference", i, int(contours.size()), rule);
+        }
+    }
+
+    return test_result();
+}
@@ -0,0 +1,79 @@
+// Thin polylines draw every vertex, whichever end of each line line() leaves out.
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "ST7789VW/pico_graphics.hpp"
+#include "test_common.hpp"
+
+namespace {
+
+    // Counts the writes to each pixel in its frame buffer
+    class PicoGraphics_PenCount : public PicoGraphics_PenRGB332 {
+    public:
+        PicoGraphics_PenCount(uint16_t width, uint16_t height) : PicoGraphics_PenRGB332(width, height, nullptr) {
+            clear_counts();
+        }
+        void set_pixel(const Point & p) override {
+            count(p)++;
+        }
+        void set_pixel_span(const Point & p, uint l) override {
+            for (uint i = 0; i < l; i++) count(Point(p.x + i, p.y))++;
+        }
+        uint8_t & count(const Point & p) {
+            return ((uint8_t *) frame_buffer)[p.y * bounds.w + p.x];
+        }
+        void clear_counts() {
+            for (int32_t i = 0; i < bounds.w * bounds.h; i++) ((uint8_t *) frame_buffer)[i] = 0;
+        }
+    };
+
+    // Every vertex is drawn, and polyline adds at most one write to those the lines make
+    void check_vertices(PicoGraphics_PenCount & g, const std::vector<Point> & points, const char * name) {
+        g.clear_counts();
+        g.polyline(points);
+
+        PicoGraphics_PenCount lines(g.bounds.w, g.bounds.h);
+        for (size_t i = 1; i < points.size(); i++) lines.line(points[i - 1], points[i]);
+
+        for (size_t i = 0; i < points.size(); i++) {
+            int const n = g.count(points[i]);
+            int const from_lines = lines.count(points[i]);
+            CHECK(n >= 1 && n <= from_lines + 1, "%s: vertex %d (%d, %d) drawn %d times, %d by the lines", name,
+                  int(i), points[i].x, points[i].y, n, from_lines);
+        }
+    }
+
+}
+
+int main() {
+    PicoGraphics_PenCount g(64, 64);
+
+    check_vertices(g, {Point(1, 10), Point(1, 1), Point(10, 1)}, "up then right");
+    check_vertices(g, {Point(2, 2), Point(12, 2), Point(12, 10), Point(2, 10), Point(2, 2)}, "closed rectangle");
+    check_vertices(g, {Point(12, 10), Point(2, 10), Point(2, 2), Point(12, 2), Point(12, 10)}, "reversed rectangle");
+    check_vertices(g, {Point(5, 5), Point(5, 5), Point(9, 5)}, "repeated vertex");
+    check_vertices(g, {Point(7, 7)}, "single point");
+
+    // random open and closed polylines whose lines are horizontal, vertical or diagonal in every
+    // direction, with repeated vertices but without coming back to one later
+    srand(1);
+    for (int t = 0; t < 1000; t++) {
+        std::vector<Point> points{Point(32, 32)};
+        for (int i = 0; i < 6; i++) {
+            Point const & p = points.back();
+            int const kind = rand() % 3;
+            int32_t const dx = kind == 1 ? 0 : rand() % 9 - 4;
+            int32_t const dy = kind == 0 ? 0 : rand() % 9 - 4;
+            Point const q(std::clamp(p.x + dx, 0, 63), std::clamp(p.y + dy, 0, 63));
+            bool revisit = false;
+            for (auto & v: points) revisit |= v == q && !(q == p);
+            if (!revisit) points.push_back(q);
+        }
+        if (t % 2) points.push_back(points.front());
+        check_vertices(g, points, "random polyline");
+    }
+
+    return test_result();
+}
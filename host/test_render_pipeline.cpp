@@ -0,0 +1,98 @@
+// RenderPipeline scans out each presented frame, with the palette it was drawn with, as a direct
+// update of the graphics would, and waits for async displays to finish reading a framebuffer
+// before handing it back.
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "pipeline/render_pipeline.hpp"
+#include "test_common.hpp"
+
+namespace {
+
+    // Keeps the last frame it was sent, as RGB565
+    class CaptureDisplay : public DisplayDriver {
+    public:
+        std::vector<uint8_t> frame;
+
+        CaptureDisplay(uint16_t width, uint16_t height) : DisplayDriver(width, height, ROTATE_0) {}
+
+        void update(PicoGraphics * graphics) override {
+            frame.clear();
+            graphics->frame_convert(PicoGraphics::PEN_RGB565, [this](void * data, size_t length) {
+                frame.insert(frame.end(), (uint8_t *) data, (uint8_t *) data + length);
+            });
+        }
+    };
+
+    // Returns from update() at once and reads the framebuffer only when polled a few times later,
+    // like a DMA transfer still running after an async update
+    class AsyncCaptureDisplay : public CaptureDisplay {
+    public:
+        AsyncCaptureDisplay(uint16_t width, uint16_t height) : CaptureDisplay(width, height) {}
+
+        void update(PicoGraphics * graphics) override {
+            sending = graphics;
+            polls = 3;
+        }
+
+        bool is_busy() override {
+            if (sending && --polls == 0) {
+                CaptureDisplay::update(sending);
+                sending = nullptr;
+            }
+            return sending != nullptr;
+        }
+
+    private:
+        PicoGraphics * sending = nullptr;
+        int polls = 0;
+    };
+
+    template<typename PenT>
+    PenT make_pen(uint16_t w, uint16_t h) {
+        if constexpr (std::is_same_v<PenT, PicoGraphics_PenDisplayList>) {
+            return PenT(w, h, 8);
+        } else {
+            return PenT(w, h, nullptr);
+        }
+    }
+
+    template<typename PenT, typename DisplayT = CaptureDisplay>
+    void test_pen(const char * name) {
+        DisplayT display(64, 32);
+        PenT graphics = make_pen<PenT>(64, 32);
+        RenderPipeline<PenT> pipeline(display, graphics);
+        pipeline.start();
+
+        for (int frame = 0; frame < 20; frame++) {
+            if (frame % 5 == 0) graphics.update_pen(3, frame * 10, 255 - frame * 10, frame);
+            graphics.set_pen(0);
+            graphics.clear();
+            graphics.set_pen(3);
+            graphics.rectangle(Rect(frame, frame % 10, 10, 10));
+
+            CaptureDisplay expected(64, 32);
+            expected.update(&graphics);
+
+            pipeline.present();
+            pipeline.wait_for_frame();
+            CHECK(display.frame == expected.frame, "%s frame %d differs from a direct update", name, frame);
+        }
+
+        pipeline.stop();
+    }
+
+}
+
+int main() {
+    test_pen<PicoGraphics_PenP4>("P4");
+    test_pen<PicoGraphics_PenP8>("P8");
+    test_pen<PicoGraphics_PenRGB565>("RGB565");
+    test_pen<PicoGraphics_PenDisplayList>("display list");
+    test_pen<PicoGraphics_PenRGB565, AsyncCaptureDisplay>("RGB565 on an async display");
+    test_pen<PicoGraphics_PenDisplayList, AsyncCaptureDisplay>("display list on an async display");
+
+    return test_result();
+}
@@ -0,0 +1,94 @@
+// ST7789 frames synchronised to the TE signal, with the edges raised by host_gpio_trigger().
+
+#include <cstdint>
+
+#include "ST7789VW/st7789.hpp"
+#include "test_common.hpp"
+
+namespace {
+
+    uint const TE_PIN = 10;
+    uint16_t const WIDTH = 320, HEIGHT = 240;
+    uint32_t const FRAME_BYTES = WIDTH * HEIGHT * sizeof(uint16_t);
+
+    uint64_t dma_bytes() {
+        uint64_t bytes = 0;
+        for (auto & channel: host_dma) bytes += channel.bytes_transferred;
+        return bytes;
+    }
+
+    // set_tear_sync() picks the fastest refresh whose period is 10% over the time to write a frame,
+    // and the refresh rates it picks from are under 10% apart
+    uint64_t frame_us(uint bus_hz, bool longest) {
+        uint64_t const write_us = uint64_t(FRAME_BYTES) * 8 * 1'000'000 / bus_hz;
+        return longest ? write_us * 121 / 100 : write_us * 11 / 10;
+    }
+
+    uint64_t const slack_us = 10'000;  // for the host scheduler
+
+}
+
+int main() {
+    SPIPins pins{spi0, 9, 6, 7, PIN_UNUSED, 8, PIN_UNUSED};
+    pins.te = TE_PIN;
+    ST7789 st7789(WIDTH, HEIGHT, ROTATE_0, false, pins);
+    PicoGraphics_PenRGB565 graphics(WIDTH, HEIGHT, nullptr);
+
+    CHECK(st7789.set_tear_sync(true), "tear sync refused with a TE pin");
+    uint64_t const min_frame_us = frame_us(spi_get_baudrate(spi0), false);
+    uint64_t const max_frame_us = frame_us(spi_get_baudrate(spi0), true);
+
+    // an armed async frame moves nothing until the TE edge, then the whole frame
+    st7789.set_async_update(true);
+    uint64_t bytes = dma_bytes();
+    st7789.update(&graphics);
+    CHECK(st7789.is_busy(), "armed frame not pending");
+    CHECK(dma_bytes() == bytes, "armed frame moved %d bytes before the TE edge", int(dma_bytes() - bytes));
+    host_gpio_trigger(TE_PIN, GPIO_IRQ_EDGE_RISE);
+    CHECK(dma_bytes() - bytes == FRAME_BYTES, "TE edge moved %d bytes, not a frame", int(dma_bytes() - bytes));
+    st7789.wait_for_update();
+
+    // without an edge wait_for_update() starts the armed frame itself after two frames
+    bytes = dma_bytes();
+    st7789.update(&graphics);
+    uint64_t start = time_us_64();
+    st7789.wait_for_update();
+    uint64_t waited = time_us_64() - start;
+    CHECK(dma_bytes() - bytes == FRAME_BYTES, "timed out frame moved %d bytes", int(dma_bytes() - bytes));
+    CHECK(waited >= 2 * min_frame_us && waited <= 2 * max_frame_us + slack_us,
+          "armed frame started after %d us without an edge", int(waited));
+
+    // damage tracking doesn't make an async update blocking, the whole frame is armed and the
+    // back buffer swapped in
+    static uint16_t back_buffer[WIDTH * HEIGHT];
+    st7789.set_async_update(true, back_buffer);
+    graphics.set_damage_tracking(true);
+    graphics.pixel(Point(3, 4));
+    void * const drawn = graphics.frame_buffer;
+    bytes = dma_bytes();
+    st7789.update(&graphics);
+    CHECK(st7789.is_busy(), "damaged frame not armed");
+    CHECK(dma_bytes() == bytes, "damaged frame moved %d bytes before the TE edge", int(dma_bytes() - bytes));
+    CHECK(graphics.frame_buffer == back_buffer, "back buffer not swapped in");
+    host_gpio_trigger(TE_PIN, GPIO_IRQ_EDGE_RISE);
+    CHECK(dma_bytes() - bytes == FRAME_BYTES, "damaged frame moved %d bytes, not a frame", int(dma_bytes() - bytes));
+    st7789.wait_for_update();
+    graphics.frame_buffer = drawn;
+    graphics.set_damage_tracking(false);
+
+    // a blocking update waits a frame and a quarter for an edge that never comes
+    st7789.set_async_update(false);
+    PicoGraphics_PenP4 converted(WIDTH, HEIGHT, nullptr);
+    start = time_us_64();
+    st7789.update(&converted);
+    waited = time_us_64() - start;
+    CHECK(waited >= min_frame_us * 5 / 4 && waited <= max_frame_us * 5 / 4 + slack_us,
+          "blocking update waited %d us for a missing edge", int(waited));
+
+    // and tear sync needs a TE pin
+    SPIPins no_te{spi1, 9, 6, 7, PIN_UNUSED, 8, PIN_UNUSED};
+    ST7789 without(WIDTH, HEIGHT, ROTATE_0, false, no_te);
+    CHECK(!without.set_tear_sync(true), "tear sync accepted without a TE pin");
+
+    return test_result();
+}
@@ -0,0 +1,86 @@
+// PicoGraphics::triangle() against the pixel at a time edge function test it replaced, on random
+// triangles of every winding, size and degeneracy, clipped and not.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "ST7789VW/pico_graphics.hpp"
+#include "test_common.hpp"
+
+namespace {
+
+    uint16_t const WIDTH = 64, HEIGHT = 48;
+
+    int64_t edge(const Point & a, const Point & b, const Point & p) {
+        return int64_t(b.x - a.x) * (p.y - a.y) - int64_t(b.y - a.y) * (p.x - a.x);
+    }
+
+    // left edges, and flat top edges, own the pixels on them
+    bool top_left(const Point & a, const Point & b) {
+        return (a.y == b.y && a.x > b.x) || a.y < b.y;
+    }
+
+    // Every pixel of the bounds inside all three edges, drawn with pixel(). The bounds stop short of
+    // the rightmost and bottom vertex, as they always have.
+    void reference_triangle(PicoGraphics & g, Point p1, Point p2, Point p3) {
+        if (edge(p1, p2, p3) < 0) std::swap(p1, p3);
+        int32_t const x0 = std::min({p1.x, p2.x, p3.x}), x1 = std::max({p1.x, p2.x, p3.x});
+        int32_t const y0 = std::min({p1.y, p2.y, p3.y}), y1 = std::max({p1.y, p2.y, p3.y});
+        for (int32_t y = y0; y < y1; y++) {
+            for (int32_t x = x0; x < x1; x++) {
+                Point const p(x, y);
+                if (edge(p2, p3, p) + (top_left(p2, p3) ? 0 : -1) >= 0 &&
+                    edge(p3, p1, p) + (top_left(p3, p1) ? 0 : -1) >= 0 &&
+                    edge(p1, p2, p) + (top_left(p1, p2) ? 0 : -1) >= 0) {
+                    g.pixel(p);
+                }
+            }
+        }
+    }
+
+    Point random_point(int32_t spread) {
+        return Point(rand() % (WIDTH + 2 * spread) - spread, rand() % (HEIGHT + 2 * spread) - spread);
+    }
+
+}
+
+int main() {
+    srand(1);
+
+    PicoGraphics_PenRGB332 filled(WIDTH, HEIGHT, nullptr);
+    PicoGraphics_PenRGB332 reference(WIDTH, HEIGHT, nullptr);
+    size_t const size = PicoGraphics_PenRGB332::buffer_size(WIDTH, HEIGHT);
+
+    int failures = 0;
+    for (int i = 0; i < 200000 && failures < 10; i++) {
+        // small triangles around a point make thin and degenerate ones common
+        Point p1 = random_point(16);
+        Point p2 = random_point(16);
+        Point p3 = random_point(16);
+        if (i % 2) {
+            p2 = Point(p1.x + rand() % 9 - 4, p1.y + rand() % 9 - 4);
+            p3 = Point(p1.x + rand() % 9 - 4, p1.y + rand() % 9 - 4);
+        }
+        Rect const clip = i % 4 == 3 ? Rect(rand() % 20, rand() % 16, 10 + rand() % 40, 8 + rand() % 30)
+                                     : Rect(0, 0, WIDTH, HEIGHT);
+
+        for (PicoGraphics * g: {(PicoGraphics *) &filled, (PicoGraphics *) &reference}) {
+            g->remove_clip();
+            g->set_pen(0);
+            g->clear();
+            g->set_clip(clip);
+            g->set_pen(255);
+        }
+        filled.triangle(p1, p2, p3);
+        reference_triangle(reference, p1, p2, p3);
+
+        if (memcmp(filled.frame_buffer, reference.frame_buffer, size) != 0) {
+            failures++;
+            CHECK(false, "triangle (%d, %d) (%d, %d) (%d, %d) clipped to %d, %d %dx%d differs from the reference",
+                  p1.x, p1.y, p2.x, p2.y, p3.x, p3.y, clip.x, clip.y, clip.w, clip.h);
+        }
+    }
+
+    return test_result();
+}
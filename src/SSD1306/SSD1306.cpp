@@ -1,19 +1,29 @@
 #include "SSD1306.h"
-#include <hardware/spi.h>
 #include "../ST7789VW/hal_impl.h"
+#include "../perf/perf_counters.hpp"
 
-SSD1306::SSD1306(uint8_t const width, uint8_t const height, uint8_t const address, i2c_inst_t * const i2c_instance)
-        : width(width), height(height), address(address), i2c_i(i2c_instance) {
+SSD1306::SSD1306(uint16_t const width, uint16_t const height, SSD1306Transport & transport)
+        : DisplayDriver(width, height, ROTATE_0), transport(&transport) {
+    init();
+}
+
+SSD1306::SSD1306(uint16_t const width, uint16_t const height, uint8_t const address, i2c_inst_t * const i2c_instance)
+        : DisplayDriver(width, height, ROTATE_0), owned_transport(new SSD1306TransportI2C(i2c_instance, address)) {
+    transport = owned_transport.get();
+    init();
+}
+
+void SSD1306::init() {
     pages = height / 8;
-    bufsize = pages * width;
     external_vcc = false;
 
-    if ((buffer = static_cast<uint8_t *>(malloc(bufsize + 1))) == nullptr) {
-        bufsize = 0;
-        // error
-    }
-
-    buffer++;
+    uint8_t const col_offset = width == 64 ? 32 : 0;
+    window[0] = SET_COL_ADDR;
+    window[1] = col_offset;
+    window[2] = col_offset + width - 1;
+    window[3] = SET_PAGE_ADDR;
+    window[4] = 0;
+    window[5] = pages - 1;
 
     gpio_put(SPI_Pins::RST, 1);
     sleep_ms(100);
@@ -22,7 +32,7 @@ SSD1306::SSD1306(uint8_t const width, uint8_t const height, uint8_t const addres
 //    gpio_put(SPI_Pins::RST, 1);
 //    sleep_ms(100);
 
-    std::vector<uint8_t> cmds = {
+    uint8_t const cmds[] = {
             SET_DISP,
             // timing and driving scheme
             SET_DISP_CLK_DIV,
@@ -53,94 +63,50 @@ SSD1306::SSD1306(uint8_t const width, uint8_t const height, uint8_t const addres
             SET_DISP | 0x01,
             // address setting
             SET_MEM_ADDR,
-            0x00  // horizontal
+            0x01  // vertical, the page order of PicoGraphics_Pen1BitY
     };
 
-    for (uint8_t cmd: cmds) {
-        write_command(cmd);
-    }
-
+    transport->write_commands(cmds, sizeof(cmds));
 }
 
 SSD1306::~SSD1306() {
-    free(buffer - 1);
-}
-
-void SSD1306::write(uint8_t addr, const uint8_t * src, size_t len) {
-    spi_write_blocking(spi0, src, len);
-    i2c_write_blocking(i2c_i, addr, src, len, false);
+    transport->wait_for_update();
 }
 
 void SSD1306::write_command(uint8_t val) {
-    gpio_put(SPI_Pins::DC, 0);
-    uint8_t d[2] = {0x00, val};
-    write(address, d, 2);
-    gpio_put(SPI_Pins::DC, 1);
+    transport->write_commands(&val, 1);
 }
 
 void SSD1306::invert(uint8_t inv) {
     write_command(SET_NORM_INV | (inv & 1));
 }
 
-void SSD1306::clear() {
-    memset(buffer, 0, bufsize);
-}
-
-void SSD1306::draw_pixel(uint32_t x, uint32_t y) {
-    if (x >= width || y >= height) return;
+void SSD1306::update(PicoGraphics * graphics) {
+    // the framebuffer is sent as it is, so anything else would be garbled or read past its end
+    bool const sendable = graphics->pen_type == PicoGraphics::PEN_1BIT_Y &&
+                          graphics->bounds.w == width && graphics->bounds.h == pages * 8;
+    assert(sendable);
+    if (!sendable) return;
 
-    buffer[x + width * (y >> 3)] |= 0x1 << (y & 0x07); // y>>3==y/8 && y&0x7==y%8
-}
+    PERF_SCOPE(PERF_UPDATE);
+    PERF_FRAME();
 
-void SSD1306::draw_char_with_font(const uint32_t x, const uint32_t y,
-                                  const uint32_t scale, const uint8_t * const font, const char c) {
-    if (c < font[3] || c > font[4])
-        return;
-
-    const uint8_t height = font[0];
-    const uint8_t width = font[1];
-    const uint8_t index = (c - font[3]);  // first column of the character data
-
-    for (uint8_t i = 0; i < width; i++) {
-        const uint8_t col = font[index * width + i + 5];
-
-        for (uint8_t j = 0; j < height; j++) {
-            if (col & (1 << j)) {
-                //draw_square(p, x + i * scale, y + j * scale, scale, scale);
-                draw_pixel(x + i, y + j);
-            }
-        }
-    }
+    // address window and GDDRAM in as few transactions as the bus allows
+    transport->write_frame(window, sizeof(window), (const uint8_t *) graphics->frame_buffer, pages * width);
 }
 
-void SSD1306::draw_string_with_font(uint32_t x, uint32_t y, uint32_t scale, const uint8_t * font, const char * s) {
-    for (int32_t x_n = x; *s; x_n += (font[1] + font[2]) * scale) {
-        draw_char_with_font(x_n, y, scale, font, *(s++));
-    }
+void SSD1306::power_off() {
+    write_command(SET_DISP);
 }
 
-void SSD1306::draw_char(uint32_t x, uint32_t y, uint32_t scale, char c) {
-    draw_char_with_font(x, y, scale, font_8x5, c);
+void SSD1306::set_async_update(bool enable) {
+    transport->set_async_update(enable);
 }
 
-void SSD1306::draw_string(uint32_t x, uint32_t y, uint32_t scale, const char * s) {
-    draw_string_with_font(x, y, scale, font_8x5, s);
+bool SSD1306::is_busy() {
+    return transport->is_busy();
 }
 
-void SSD1306::show() {
-    std::vector<uint8_t> payload = {SET_COL_ADDR, 0, static_cast<uint8_t>(width - 1), SET_PAGE_ADDR, 0,
-                                    static_cast<uint8_t>(pages - 1)};
-
-    if (width == 64) {
-        payload[1] += 32;
-        payload[2] += 32;
-    }
-
-    for (const uint8_t data: payload) {
-        write_command(data);
-    }
-
-    *(buffer - 1) = 0x40;
-
-    write(address, buffer - 1, bufsize + 1);
+void SSD1306::wait_for_update() {
+    transport->wait_for_update();
 }
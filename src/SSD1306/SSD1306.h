@@ -1,14 +1,12 @@
 #pragma once
 
+#include <cassert>
 #include <cstdint>
-#include <cstdlib>
-#include <cstring>
 #include <memory>
-#include <string>
-#include <vector>
 #include <hardware/i2c.h>
 
-#include "../font.h"
+#include "../ST7789VW/pico_graphics.hpp"
+#include "SSD1306_transport.h"
 
 typedef enum {
     SDA = 0,
@@ -43,40 +41,38 @@ typedef enum {
     SET_CHARGE_PUMP = 0x8D
 } ssd1306_command_t;
 
-class SSD1306 {
-    i2c_inst_t * i2c_i;
-    uint8_t * buffer;  // display buffer
-    size_t bufsize;  // buffer size
+// Draw with a PicoGraphics_Pen1BitY of the same size, its framebuffer is in the vertical
+// addressing layout of the display RAM and is sent without conversion. update() of any other pen
+// or size asserts, or sends nothing with assertions off.
+class SSD1306 : public DisplayDriver {
+    SSD1306Transport * transport;
+    std::unique_ptr<SSD1306Transport> owned_transport;  // set when constructed from an I2C instance
+    uint8_t window[6];  // column and page address commands sent by update()
+
+    void init();
 
 public:
     bool external_vcc;  // whether display uses external vcc
-    uint8_t width;
-    uint8_t height;
     uint8_t pages;  // stores pages of display (calculated on initialization
-    uint8_t address;  // i2c address of display
 
-    SSD1306(uint8_t width, uint8_t height, uint8_t address, i2c_inst_t * i2c_instance);
+    SSD1306(uint16_t width, uint16_t height, SSD1306Transport & transport);
 
-    ~SSD1306();
+    SSD1306(uint16_t width, uint16_t height, uint8_t address, i2c_inst_t * i2c_instance);
 
-    void write(uint8_t addr, const uint8_t * src, size_t len);
+    ~SSD1306();
 
     void write_command(uint8_t val);
 
     void invert(uint8_t inv);
 
-    void clear();
+    void update(PicoGraphics * graphics) override;
 
-    void draw_pixel(uint32_t x, uint32_t y);
+    void power_off() override;
 
-    void draw_char_with_font(uint32_t x, uint32_t y, uint32_t scale, const uint8_t * font, char c);
+    // Send frames from DMA instead of blocking on the bus, see SSD1306Transport::set_async_update()
+    void set_async_update(bool enable);
 
-    void draw_string_with_font(uint32_t x, uint32_t y, uint32_t scale, const uint8_t * font, const char * s);
+    bool is_busy() override;
 
-    void draw_char(uint32_t x, uint32_t y, uint32_t scale, char c);
-
-    void draw_string(uint32_t x, uint32_t y, uint32_t scale, const char * s);
-
-    void show();
+    void wait_for_update();
 };
-
@@ -0,0 +1,226 @@
+#include "SSD1306_transport.h"
+
+#include <algorithm>
+#include <cstring>
+#include <pico/stdlib.h>
+
+#include "../perf/perf_counters.hpp"
+
+void SSD1306Transport::wait_for_update() {
+    PERF_SCOPE(PERF_DMA_WAIT);
+    while (is_busy()) {
+        tight_loop_contents();
+    }
+}
+
+void SSD1306Transport::claim_dma(uint dreq, volatile void * write_addr, dma_channel_transfer_size size) {
+    dma_channel = dma_claim_unused_channel(true);
+
+    dma_channel_config config = dma_channel_get_default_config(dma_channel);
+    channel_config_set_transfer_data_size(&config, size);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, dreq);
+    dma_channel_configure(dma_channel, &config, write_addr, nullptr, 0, false);
+}
+
+void SSD1306Transport::unclaim_dma() {
+    wait_for_update();
+    dma_channel_unclaim(dma_channel);
+    dma_channel = -1;
+}
+
+SSD1306TransportI2C::~SSD1306TransportI2C() {
+    set_async_update(false);
+}
+
+void SSD1306TransportI2C::write_commands(const uint8_t * cmds, size_t len) {
+    wait_for_update();
+    PERF_BYTES(len);
+
+    uint8_t buf[32];
+    buf[0] = 0x00;  // Co = 0, D/C# = 0: the rest of the transaction is commands
+
+    while (len) {
+        size_t const n = std::min(len, sizeof(buf) - 1);
+        memcpy(buf + 1, cmds, n);
+        i2c_write_blocking(i2c, address, buf, n + 1, false);
+        cmds += n;
+        len -= n;
+    }
+}
+
+void SSD1306TransportI2C::write_frame(const uint8_t * window, size_t window_len, const uint8_t * data, size_t len) {
+    wait_for_update();
+
+    // the window as control/command pairs with Co = 1, then the data control byte
+    uint8_t header[MAX_WINDOW_LEN * 2 + 1];
+    window_len = std::min(window_len, MAX_WINDOW_LEN);
+    for (size_t i = 0; i < window_len; i++) {
+        header[i * 2] = 0x80;
+        header[i * 2 + 1] = window[i];
+    }
+    header[window_len * 2] = 0x40;
+    size_t const header_len = window_len * 2 + 1;
+    PERF_BYTES(header_len + len);
+
+    begin();
+
+    if (!async_update) {
+        // fed straight into the FIFO so the header and the data go out as one transaction
+        if (push(header, header_len, len == 0) && len) {
+            push(data, len, true);
+        }
+        PERF_SCOPE(PERF_DMA_WAIT);
+        while (bus_busy()) {
+            tight_loop_contents();
+        }
+        return;
+    }
+
+    // the DMA has to write whole IC_DATA_CMD words, narrower writes are replicated across the
+    // bus and would set the CMD (read) bit. The last byte also carries the STOP condition.
+    size_t const total = header_len + len;
+    if (dma_buffer.size() < total) {
+        dma_buffer.resize(total);
+    }
+    std::copy(header, header + header_len, dma_buffer.begin());
+    std::copy(data, data + len, dma_buffer.begin() + header_len);
+    dma_buffer[total - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    dma_channel_transfer_from_buffer_now(dma_channel, dma_buffer.data(), total);
+}
+
+void SSD1306TransportI2C::begin() {
+    i2c_hw_t * hw = i2c_get_hw(i2c);
+    hw->enable = 0;
+    hw->tar = address;
+    hw->enable = 1;
+}
+
+bool SSD1306TransportI2C::push(const uint8_t * src, size_t len, bool stop) {
+    i2c_hw_t * hw = i2c_get_hw(i2c);
+    for (size_t i = 0; i < len; i++) {
+        while (!i2c_get_write_available(i2c)) {
+            if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) return false;
+        }
+        hw->data_cmd = src[i] | (stop && i == len - 1 ? I2C_IC_DATA_CMD_STOP_BITS : 0);
+    }
+    return true;
+}
+
+bool SSD1306TransportI2C::bus_busy() {
+    i2c_hw_t * hw = i2c_get_hw(i2c);
+    if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+        // NACK or lost arbitration, the controller has flushed its FIFO so drop the rest of the frame
+        if (dma_channel >= 0) dma_channel_abort(dma_channel);
+        (void) hw->clr_tx_abrt;
+        return false;
+    }
+
+    return hw->txflr || (hw->status & I2C_IC_STATUS_ACTIVITY_BITS);
+}
+
+void SSD1306TransportI2C::set_async_update(bool enable) {
+    if (enable == async_update) return;
+
+    if (enable) {
+        claim_dma(i2c_get_dreq(i2c, true), &i2c_get_hw(i2c)->data_cmd, DMA_SIZE_16);
+    } else {
+        unclaim_dma();
+        dma_buffer.clear();
+        dma_buffer.shrink_to_fit();
+    }
+
+    async_update = enable;
+}
+
+bool SSD1306TransportI2C::is_busy() {
+    if (!async_update) return false;
+
+    return bus_busy() || dma_channel_is_busy(dma_channel);
+}
+
+SSD1306TransportSPI::SSD1306TransportSPI(spi_inst_t * spi, uint dc, uint cs) : spi(spi), dc(dc), cs(cs) {
+    gpio_init(dc);
+    gpio_set_dir(dc, GPIO_OUT);
+
+    if (cs != PIN_UNUSED) {
+        gpio_init(cs);
+        gpio_set_dir(cs, GPIO_OUT);
+        gpio_put(cs, 1);
+    }
+}
+
+SSD1306TransportSPI::~SSD1306TransportSPI() {
+    set_async_update(false);
+}
+
+void SSD1306TransportSPI::select(bool data) {
+    gpio_put(dc, data);
+    if (cs != PIN_UNUSED) gpio_put(cs, 0);
+}
+
+void SSD1306TransportSPI::deselect() {
+    if (cs != PIN_UNUSED) gpio_put(cs, 1);
+    gpio_put(dc, 1);
+}
+
+void SSD1306TransportSPI::write_commands(const uint8_t * cmds, size_t len) {
+    wait_for_update();
+    PERF_BYTES(len);
+
+    select(false);
+    spi_write_blocking(spi, cmds, len);
+    deselect();
+}
+
+void SSD1306TransportSPI::write_frame(const uint8_t * window, size_t window_len, const uint8_t * data, size_t len) {
+    wait_for_update();
+    PERF_BYTES(window_len + len);
+
+    select(false);
+    spi_write_blocking(spi, window, window_len);
+    gpio_put(dc, 1);
+
+    if (!async_update) {
+        spi_write_blocking(spi, data, len);
+        deselect();
+        return;
+    }
+
+    if (dma_buffer.size() < len) {
+        dma_buffer.resize(len);
+    }
+    memcpy(dma_buffer.data(), data, len);
+
+    // CS is released by is_busy() once the frame has drained
+    cs_active = true;
+    dma_channel_transfer_from_buffer_now(dma_channel, dma_buffer.data(), len);
+}
+
+void SSD1306TransportSPI::set_async_update(bool enable) {
+    if (enable == async_update) return;
+
+    if (enable) {
+        claim_dma(spi_get_dreq(spi, true), &spi_get_hw(spi)->dr, DMA_SIZE_8);
+    } else {
+        unclaim_dma();
+        dma_buffer.clear();
+        dma_buffer.shrink_to_fit();
+    }
+
+    async_update = enable;
+}
+
+bool SSD1306TransportSPI::is_busy() {
+    if (!async_update) return false;
+
+    if (dma_channel_is_busy(dma_channel) || spi_is_busy(spi)) return true;
+
+    if (cs_active) {
+        deselect();
+        cs_active = false;
+    }
+    return false;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <hardware/i2c.h>
+#include <hardware/spi.h>
+#include <hardware/dma.h>
+
+#include "../ST7789VW/pimoroni_common.hpp"
+
+// Bus used by SSD1306 to reach the controller. write_frame() sends the address window and the
+// display data together in as few transactions as the bus allows.
+class SSD1306Transport {
+public:
+    // longest address window write_frame() accepts
+    static const size_t MAX_WINDOW_LEN = 6;
+
+    virtual ~SSD1306Transport() = default;
+
+    virtual void write_commands(const uint8_t * cmds, size_t len) = 0;
+
+    // data is sent as is, so a framebuffer in the controller's memory layout can be passed directly
+    virtual void write_frame(const uint8_t * window, size_t window_len, const uint8_t * data, size_t len) = 0;
+
+    // Send frames from DMA. write_frame() copies the data into a staging buffer and returns as
+    // soon as the transfer has started, so the next frame can be drawn while this one is sent.
+    virtual void set_async_update(bool enable) = 0;
+
+    virtual bool is_busy() = 0;
+
+    void wait_for_update();
+
+protected:
+    bool async_update = false;
+    int dma_channel = -1;
+
+    void claim_dma(uint dreq, volatile void * write_addr, dma_channel_transfer_size size);
+
+    void unclaim_dma();
+};
+
+// I2C, with the control bytes the SSD1306 expects in front of commands and data
+class SSD1306TransportI2C : public SSD1306Transport {
+    i2c_inst_t * i2c;
+    std::vector<uint16_t> dma_buffer;  // frame as IC_DATA_CMD words
+
+    void begin();
+
+    bool push(const uint8_t * src, size_t len, bool stop);
+
+    bool bus_busy();
+
+public:
+    uint8_t address;  // i2c address of display
+
+    SSD1306TransportI2C(i2c_inst_t * i2c, uint8_t address) : i2c(i2c), address(address) {}
+
+    ~SSD1306TransportI2C() override;
+
+    void write_commands(const uint8_t * cmds, size_t len) override;
+
+    void write_frame(const uint8_t * window, size_t window_len, const uint8_t * data, size_t len) override;
+
+    void set_async_update(bool enable) override;
+
+    bool is_busy() override;
+};
+
+// 4-wire SPI, commands and data told apart by the DC pin. Without a CS pin the hardware chip
+// select of the SPI block is expected to be wired up instead.
+class SSD1306TransportSPI : public SSD1306Transport {
+    spi_inst_t * spi;
+    uint dc;
+    uint cs;
+    bool cs_active = false;  // CS is held low for a DMA frame
+    std::vector<uint8_t> dma_buffer;
+
+    void select(bool data);
+
+    void deselect();
+
+public:
+    SSD1306TransportSPI(spi_inst_t * spi, uint dc, uint cs = PIN_UNUSED);
+
+    ~SSD1306TransportSPI() override;
+
+    void write_commands(const uint8_t * cmds, size_t len) override;
+
+    void write_frame(const uint8_t * window, size_t window_len, const uint8_t * data, size_t len) override;
+
+    void set_async_update(bool enable) override;
+
+    bool is_busy() override;
+};
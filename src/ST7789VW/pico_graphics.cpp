@@ -1,4 +1,13 @@
 #include "pico_graphics.hpp"
+#include "../font.h"
+#include "../perf/perf_counters.hpp"
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#if PICO_GRAPHICS_INTERP
+#include "hardware/interp.h"
+#endif
 
 
 const uint8_t dither16_pattern[16] = {0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5};
@@ -15,19 +24,51 @@ void PicoGraphics::set_pixel_dither(const Point & p, const RGB565 & c) {};
 
 void PicoGraphics::set_pixel_dither(const Point & p, const uint8_t & c) {};
 
+void PicoGraphics::set_pixel_alpha(const Point & p, uint8_t alpha) {
+    if (alpha >= 128) set_pixel(p);
+}
+
+void PicoGraphics::set_pixels(const Point * points, size_t count) {
+    for (size_t i = 0; i < count; i++) set_pixel(points[i]);
+}
+
+void PicoGraphics::set_pixel_spans(const Span * spans, size_t count) {
+    for (size_t i = 0; i < count; i++) set_pixel_span(spans[i].p, spans[i].l);
+}
+
+void PicoGraphics::set_vertical_spans(const Span * spans, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        for (int32_t y = 0; y < spans[i].l; y++) set_pixel(Point(spans[i].p.x, spans[i].p.y + y));
+    }
+}
+
 void PicoGraphics::frame_convert(PenType type, conversion_callback_func callback) {};
 
+void PicoGraphics::convert_rgb565(uint32_t offset, uint32_t count, RGB565 * dst) {};
+
 void
-PicoGraphics::sprite(void * data, const Point & sprite, const Point & dest, const int scale, const int transparent) {};
+PicoGraphics::sprite(void * data, const Point & sprite, const Point & dest, const int scale, const int transparent) {
+    Bitmap sheet{PEN_RGB332, data, 128, 128, 128};
+    sheet.transparent = transparent;
+    blit(sheet, Rect(sprite.x << 3, sprite.y << 3, 8, 8), dest, scale);
+}
 
 void PicoGraphics::set_dimensions(int width, int height) {
     bounds = clip = {0, 0, width, height};
+    if (track_damage) set_damage_tracking(true);
 }
 
 void PicoGraphics::set_framebuffer(void * frame_buffer) {
     this->frame_buffer = frame_buffer;
 }
 
+void PicoGraphics::set_convert_chunk(uint32_t pixels) {
+    // keep it even so both halves of the convert buffer are word aligned
+    convert_chunk = std::max((pixels + 1) & ~1u, 2u);
+    convert_buffer.clear();
+    convert_buffer.shrink_to_fit();
+}
+
 //void PicoGraphics::set_font(const bitmap::font_t * font) {
 //    this->bitmap_font = font;
 //    this->hershey_font = nullptr;
@@ -53,6 +94,119 @@ void PicoGraphics::set_framebuffer(void * frame_buffer) {
 //    }
 //}
 
+void PicoGraphics::set_damage_tracking(bool enable) {
+    track_damage = enable;
+    if (enable) {
+        int32_t const cols = (bounds.w + DAMAGE_TILE - 1) >> DAMAGE_TILE_SHIFT;
+        int32_t const rows = (bounds.h + DAMAGE_TILE - 1) >> DAMAGE_TILE_SHIFT;
+        damage_stride = (cols + 31) / 32;
+        damage_tiles.assign(damage_stride * rows, 0);
+    } else {
+        damage_tiles.clear();
+        damage_tiles.shrink_to_fit();
+    }
+}
+
+void PicoGraphics::mark_damage(const Rect & r) {
+    if (!track_damage) return;
+
+    Rect clipped = r.intersection(bounds);
+    if (clipped.empty()) return;
+
+    int32_t const x0 = clipped.x >> DAMAGE_TILE_SHIFT;
+    int32_t const x1 = (clipped.x + clipped.w - 1) >> DAMAGE_TILE_SHIFT;
+    int32_t const y0 = clipped.y >> DAMAGE_TILE_SHIFT;
+    int32_t const y1 = (clipped.y + clipped.h - 1) >> DAMAGE_TILE_SHIFT;
+
+    for (int32_t y = y0; y <= y1; y++) {
+        uint32_t * row = &damage_tiles[y * damage_stride];
+        for (int32_t word = x0 >> 5; word <= x1 >> 5; word++) {
+            // bits x0..x1 falling within this word
+            uint32_t mask = ~0u;
+            if (word == x0 >> 5) mask &= ~0u << (x0 & 31);
+            if (word == x1 >> 5) mask &= ~0u >> (31 - (x1 & 31));
+            row[word] |= mask;
+        }
+    }
+}
+
+void PicoGraphics::clear_damage() {
+    std::fill(damage_tiles.begin(), damage_tiles.end(), 0);
+}
+
+bool PicoGraphics::has_damage() const {
+    return std::any_of(damage_tiles.begin(), damage_tiles.end(), [](uint32_t word) { return word != 0; });
+}
+
+void PicoGraphics::get_damage(damage_callback_func callback) const {
+    if (!track_damage) return;
+
+    // runs of dirty tiles are grown downwards while the next tile row has a run with the same extent
+    static constexpr int MAX_OPEN = 32;
+    Rect open[MAX_OPEN];
+    bool extended[MAX_OPEN];
+    int open_count = 0;
+
+    auto emit = [&](const Rect & r) { callback(r.intersection(bounds)); };
+
+    int32_t const cols = (bounds.w + DAMAGE_TILE - 1) >> DAMAGE_TILE_SHIFT;
+    int32_t const rows = (bounds.h + DAMAGE_TILE - 1) >> DAMAGE_TILE_SHIFT;
+
+    for (int32_t ty = 0; ty < rows; ty++) {
+        uint32_t const * row = &damage_tiles[ty * damage_stride];
+        std::fill(extended, extended + open_count, false);
+
+        int32_t tx = 0;
+        while (tx < cols) {
+            if (row[tx >> 5] == 0) {
+                tx = (tx | 31) + 1;
+                continue;
+            }
+            if (!(row[tx >> 5] & (1u << (tx & 31)))) {
+                tx++;
+                continue;
+            }
+
+            int32_t start = tx;
+            while (tx < cols && (row[tx >> 5] & (1u << (tx & 31)))) tx++;
+            Rect run(start << DAMAGE_TILE_SHIFT, ty << DAMAGE_TILE_SHIFT,
+                     (tx - start) << DAMAGE_TILE_SHIFT, DAMAGE_TILE);
+
+            int i = 0;
+            while (i < open_count && !(open[i].x == run.x && open[i].w == run.w && open[i].y + open[i].h == run.y)) {
+                i++;
+            }
+            if (i < open_count) {
+                open[i].h += DAMAGE_TILE;
+                extended[i] = true;
+            } else {
+                if (open_count == MAX_OPEN) {
+                    emit(run);
+                    continue;
+                }
+                open[open_count] = run;
+                extended[open_count] = true;
+                open_count++;
+            }
+        }
+
+        // anything that didn't continue into this row is complete
+        for (int i = 0; i < open_count;) {
+            if (!extended[i]) {
+                emit(open[i]);
+                open[i] = open[--open_count];
+                extended[i] = extended[open_count];
+            } else {
+                i++;
+            }
+        }
+    }
+
+    for (int i = 0; i < open_count; i++) {
+        emit(open[i]);
+    }
+}
+
 void PicoGraphics::set_clip(const Rect & r) {
     clip = bounds.intersection(r);
 }
@@ -61,16 +215,25 @@ void PicoGraphics::remove_clip() {
     clip = bounds;
 }
 
+void PicoGraphics::set_blend(uint8_t alpha, BlendMode mode) {
+    blend_alpha = alpha;
+    blend_mode = mode;
+}
+
 void PicoGraphics::clear() {
+    PERF_SCOPE(PERF_RENDER);
     rectangle(clip);
 }
 
 void PicoGraphics::pixel(const Point & p) {
+    PERF_SCOPE(PERF_RENDER);
     if (!clip.contains(p)) return;
+    if (track_damage) mark_damage(Rect(p.x, p.y, 1, 1));
     set_pixel(p);
 }
 
 void PicoGraphics::pixel_span(const Point & p, int32_t l) {
+    PERF_SCOPE(PERF_RENDER);
     // check if span in bounds
     if (p.x + l < clip.x || p.x >= clip.x + clip.w ||
         p.y < clip.y || p.y >= clip.y + clip.h)
@@ -85,15 +248,19 @@ void PicoGraphics::pixel_span(const Point & p, int32_t l) {
     if (clipped.x + l >= clip.x + clip.w) { l = clip.x + clip.w - clipped.x; }
 
     Point dest(clipped.x, clipped.y);
+    if (track_damage) mark_damage(Rect(dest.x, dest.y, l, 1));
     set_pixel_span(dest, l);
 }
 
 void PicoGraphics::rectangle(const Rect & r) {
+    PERF_SCOPE(PERF_RENDER);
     // clip and/or discard depending on rectangle visibility
     Rect clipped = r.intersection(clip);
 
     if (clipped.empty()) return;
 
+    if (track_damage) mark_damage(clipped);
+
     Point dest(clipped.x, clipped.y);
     while (clipped.h--) {
         // draw span of pixels for this row
@@ -104,10 +271,13 @@ void PicoGraphics::rectangle(const Rect & r) {
 }
 
 void PicoGraphics::circle(const Point & p, int32_t radius) {
+    PERF_SCOPE(PERF_RENDER);
     // circle in screen bounds?
     Rect bounds = Rect(p.x - radius, p.y - radius, radius * 2, radius * 2);
     if (!bounds.intersects(clip)) return;
 
+    if (track_damage) mark_damage(Rect(p.x - radius, p.y - radius, radius * 2 + 1, radius * 2 + 1).intersection(clip));
+
     int ox = radius, oy = 0, err = -radius;
     while (ox >= oy) {
         int last_oy = oy;
@@ -172,15 +342,277 @@ void PicoGraphics::circle(const Point & p, int32_t radius) {
 //    return 0;
 //}
 
+// Until the font support above is brought over, text is drawn with the 8x5 bitmap font at integer
+// scales. Glyphs are stored a byte per column, least significant bit at the top.
+void PicoGraphics::character(const char c, const Point & p, float s, float a) {
+    PERF_SCOPE(PERF_RENDER);
+    const uint8_t * font = font_8x5;
+    if (c < font[3] || c > font[4]) return;
+
+    int32_t const scale = std::max(1, int32_t(s));
+    uint8_t const height = font[0];
+    uint8_t const width = font[1];
+    const uint8_t * glyph = &font[5 + (c - font[3]) * width];
+
+    for (uint8_t x = 0; x < width; x++) {
+        uint8_t const col = glyph[x];
+
+        // one rectangle per vertical run of set bits
+        for (uint8_t y = 0; y < height;) {
+            if (!(col & (1 << y))) {
+                y++;
+                continue;
+            }
+            uint8_t y2 = y;
+            while (y2 < height && (col & (1 << y2))) y2++;
+            rectangle(Rect(p.x + x * scale, p.y + y * scale, scale, (y2 - y) * scale));
+            y = y2;
+        }
+    }
+}
+
+void PicoGraphics::text(const std::string & t, const Point & p, int32_t wrap, float s, float a, uint8_t letter_spacing) {
+    PERF_SCOPE(PERF_RENDER);
+    int32_t const scale = std::max(1, int32_t(s));
+    int32_t const width = font_8x5[1] * scale;
+    int32_t const advance = width + letter_spacing * scale;
+    int32_t const line_height = (font_8x5[0] + 1) * scale;
+
+    Point c = p;
+    for (char ch: t) {
+        if (ch == '\n' || (wrap > 0 && c.x != p.x && c.x + width > p.x + wrap)) {
+            c.x = p.x;
+            c.y += line_height;
+            if (ch == '\n') continue;
+        }
+        character(ch, c, s, a);
+        c.x += advance;
+    }
+}
+
+int32_t PicoGraphics::measure_text(const std::string & t, float s, uint8_t letter_spacing) {
+    if (t.empty()) return 0;
+    int32_t const scale = std::max(1, int32_t(s));
+    return int32_t(t.size()) * (font_8x5[1] + letter_spacing) * scale - letter_spacing * scale;
+}
+
 int32_t orient2d(Point p1, Point p2, Point p3) {
     return (p2.x - p1.x) * (p3.y - p1.y) - (p2.y - p1.y) * (p3.x - p1.x);
 }
 
+void PicoGraphics::batch_span(const Span & span, bool vertical) {
+    if (batch_spans.capacity() < BATCH_SIZE) batch_spans.reserve(BATCH_SIZE);
+    batch_spans.push_back(span);
+    if (batch_spans.size() == BATCH_SIZE) flush_spans(vertical);
+}
+
+void PicoGraphics::flush_spans(bool vertical) {
+    if (batch_spans.empty()) return;
+    if (vertical) {
+        set_vertical_spans(batch_spans.data(), batch_spans.size());
+    } else {
+        set_pixel_spans(batch_spans.data(), batch_spans.size());
+    }
+    batch_spans.clear();
+}
+
+void PicoGraphics::rectangles(const Rect * rects, size_t count) {
+    PERF_SCOPE(PERF_RENDER);
+    bool vertical = false;
+    for (size_t i = 0; i < count; i++) {
+        Rect const r = rects[i].intersection(clip);
+        if (r.empty()) continue;
+        if (track_damage) mark_damage(r);
+
+        // as rows, which the pens fill contiguously, apart from single columns
+        bool const columns = r.w == 1 && r.h > 1;
+        if (columns != vertical) {
+            flush_spans(vertical);
+            vertical = columns;
+        }
+        if (columns) {
+            for (int32_t x = r.x; x < r.x + r.w; x++) batch_span(Span(Point(x, r.y), r.h), true);
+        } else {
+            for (int32_t y = r.y; y < r.y + r.h; y++) batch_span(Span(Point(r.x, y), r.w), false);
+        }
+    }
+    flush_spans(vertical);
+}
+
+void PicoGraphics::pixels(const Point * points, size_t count) {
+    PERF_SCOPE(PERF_RENDER);
+    if (batch_points.capacity() < BATCH_SIZE) batch_points.reserve(BATCH_SIZE);
+    for (size_t i = 0; i < count; i++) {
+        if (!clip.contains(points[i])) continue;
+        if (track_damage) mark_damage(Rect(points[i].x, points[i].y, 1, 1));
+
+        batch_points.push_back(points[i]);
+        if (batch_points.size() == BATCH_SIZE) {
+            set_pixels(batch_points.data(), batch_points.size());
+            batch_points.clear();
+        }
+    }
+    if (!batch_points.empty()) {
+        set_pixels(batch_points.data(), batch_points.size());
+        batch_points.clear();
+    }
+}
+
+void PicoGraphics::pixel_spans(const Span * spans, size_t count) {
+    PERF_SCOPE(PERF_RENDER);
+    for (size_t i = 0; i < count; i++) {
+        const Span & s = spans[i];
+        int32_t const x0 = std::max(s.p.x, clip.x);
+        int32_t const x1 = std::min(s.p.x + s.l, clip.x + clip.w);
+        if (s.p.y < clip.y || s.p.y >= clip.y + clip.h || x0 >= x1) continue;
+        if (track_damage) mark_damage(Rect(x0, s.p.y, x1 - x0, 1));
+
+        batch_span(Span(Point(x0, s.p.y), x1 - x0), false);
+    }
+    flush_spans(false);
+}
+
+void PicoGraphics::vertical_spans(const Span * spans, size_t count) {
+    PERF_SCOPE(PERF_RENDER);
+    for (size_t i = 0; i < count; i++) {
+        const Span & s = spans[i];
+        int32_t const y0 = std::max(s.p.y, clip.y);
+        int32_t const y1 = std::min(s.p.y + s.l, clip.y + clip.h);
+        if (s.p.x < clip.x || s.p.x >= clip.x + clip.w || y0 >= y1) continue;
+        if (track_damage) mark_damage(Rect(s.p.x, y0, 1, y1 - y0));
+
+        batch_span(Span(Point(s.p.x, y0), y1 - y0), true);
+    }
+    flush_spans(true);
+}
+
+static inline uint32_t bitmap_pixel(const PicoGraphics::Bitmap & bitmap, const uint8_t * row, int32_t x) {
+    switch (bitmap.format) {
+        case PicoGraphics::PEN_1BIT:
+            return (row[x >> 3] >> (7 - (x & 0b111))) & 1;
+        case PicoGraphics::PEN_P4:
+            return (row[x >> 1] >> ((~x & 0b1) * 4)) & 0b1111;
+        case PicoGraphics::PEN_P8:
+        case PicoGraphics::PEN_RGB332:
+            return row[x];
+        case PicoGraphics::PEN_RGB565:
+            return ((const uint16_t *) row)[x];
+        case PicoGraphics::PEN_RGB888:
+            return ((const uint32_t *) row)[x];
+        default:
+            return 0;
+    }
+}
+
+static RGB bitmap_rgb(const PicoGraphics::Bitmap & bitmap, uint32_t v) {
+    switch (bitmap.format) {
+        case PicoGraphics::PEN_1BIT:
+            return v ? RGB(255, 255, 255) : RGB(0, 0, 0);
+        case PicoGraphics::PEN_P4:
+        case PicoGraphics::PEN_P8:
+            return bitmap.palette ? bitmap.palette[v] : RGB(v, v, v);
+        case PicoGraphics::PEN_RGB332:
+            return RGB(RGB332(v));
+        case PicoGraphics::PEN_RGB565:
+            return RGB(RGB565(v));
+        default:
+            return RGB((v >> 16) & 0xff, (v >> 8) & 0xff, v & 0xff);
+    }
+}
+
+void PicoGraphics::blit(const Bitmap & bitmap, const Rect & src, const Point & dest, int32_t scale) {
+    PERF_SCOPE(PERF_RENDER);
+    switch (bitmap.format) {
+        case PEN_1BIT:
+        case PEN_P4:
+        case PEN_P8:
+        case PEN_RGB332:
+        case PEN_RGB565:
+        case PEN_RGB888:
+            break;
+        default:
+            return;
+    }
+    if (scale < 1) return;
+
+    // the part of src inside the bitmap, where it lands and what of that is inside the clip
+    Rect const source = src.intersection(Rect(0, 0, bitmap.width, bitmap.height));
+    if (source.empty()) return;
+    Point const origin(dest.x + (source.x - src.x) * scale, dest.y + (source.y - src.y) * scale);
+    Rect const target = Rect(origin.x, origin.y, source.w * scale, source.h * scale).intersection(clip);
+    if (target.empty()) return;
+    if (track_damage) mark_damage(target);
+
+    // Pixel values can go straight to the pen when the bitmap is in its format, the 1 bit pen takes
+    // brightness instead
+    PenType const native = pen_type == PEN_DISPLAY_LIST ? PEN_RGB565 : pen_type;
+    bool const raw = bitmap.format == native && native != PEN_1BIT;
+    bool pen_set = false;
+    uint32_t pen_value = 0;
+
+    auto opaque = [&](const uint8_t * mask_row, int32_t x, uint32_t v) {
+        if (mask_row && !(mask_row[x >> 3] & (0x80 >> (x & 0b111)))) return false;
+        return int32_t(v) != bitmap.transparent;
+    };
+
+    // The first column and row may be partly clipped, after that each source pixel covers scale
+    // destination pixels both ways
+    int32_t const x_skip = target.x - origin.x;
+    int32_t const y_skip = target.y - origin.y;
+    int32_t const first_sx = source.x + x_skip / scale;
+    int32_t const first_w = scale - x_skip % scale;
+    int32_t const x_end = target.x + target.w;
+    int32_t const y_end = target.y + target.h;
+
+    int32_t sy = source.y + y_skip / scale;
+    int32_t rows = scale - y_skip % scale;
+    for (int32_t y = target.y; y < y_end; y += rows, rows = scale, sy++) {
+        rows = std::min(rows, y_end - y);
+        const uint8_t * row = (const uint8_t *) bitmap.data + sy * bitmap.stride;
+        const uint8_t * mask_row = bitmap.mask ? bitmap.mask + sy * bitmap.mask_stride : nullptr;
+
+        int32_t x = target.x;
+        int32_t sx = first_sx;
+        int32_t w = first_w;
+        uint32_t v = bitmap_pixel(bitmap, row, sx);
+        bool o = opaque(mask_row, sx, v);
+
+        // runs of the same colour, or of transparent pixels, then go out as one span per row
+        while (x < x_end) {
+            int32_t const run_x = x;
+            uint32_t const run_v = v;
+            bool const run_opaque = o;
+            do {
+                x = std::min(x + w, x_end);
+                w = scale;
+                if (x < x_end) {
+                    v = bitmap_pixel(bitmap, row, ++sx);
+                    o = opaque(mask_row, sx, v);
+                }
+            } while (x < x_end && o == run_opaque && (!o || v == run_v));
+
+            if (!run_opaque) continue;
+            if (!pen_set || run_v != pen_value) {
+                if (raw) {
+                    set_pen(run_v);
+                } else {
+                    RGB const c = bitmap_rgb(bitmap, run_v);
+                    set_pen(c.r, c.g, c.b);
+                }
+                pen_set = true;
+                pen_value = run_v;
+            }
+            for (int32_t r = 0; r < rows; r++) set_pixel_span(Point(run_x, y + r), x - run_x);
+        }
+    }
+}
+
 bool is_top_left(const Point & p1, const Point & p2) {
     return (p1.y == p2.y && p1.x > p2.x) || (p1.y < p2.y);
 }
 
 void PicoGraphics::triangle(Point p1, Point p2, Point p3) {
+    PERF_SCOPE(PERF_RENDER);
     Rect triangle_bounds(
             Point(std::min(p1.x, std::min(p2.x, p3.x)), std::min(p1.y, std::min(p2.y, p3.y))),
             Point(std::max(p1.x, std::max(p2.x, p3.x)), std::max(p1.y, std::max(p2.y, p3.y))));
@@ -193,6 +625,8 @@ void PicoGraphics::triangle(Point p1, Point p2, Point p3) {
         return;
     }
 
+    if (track_damage) mark_damage(triangle_bounds);
+
     // fix "winding" of vertices if needed
     int32_t winding = orient2d(p1, p2, p3);
     if (winding < 0) {
@@ -219,22 +653,29 @@ void PicoGraphics::triangle(Point p1, Point p2, Point p3) {
     int32_t w1row = orient2d(p3, p1, tl) + bias1;
     int32_t w2row = orient2d(p1, p2, tl) + bias2;
 
+    // Each edge function is linear along a row, so where it is >= 0 bounds the row's span on one
+    // side. The span is then exactly the pixels the per pixel test would cover.
+    int32_t const a[3] = {a12, a20, a01};
+
     for (int32_t y = 0; y < triangle_bounds.h; y++) {
-        int32_t w0 = w0row;
-        int32_t w1 = w1row;
-        int32_t w2 = w2row;
-
-        Point dest = Point(triangle_bounds.x, triangle_bounds.y + y);
-        for (int32_t x = 0; x < triangle_bounds.w; x++) {
-            if ((w0 | w1 | w2) >= 0) {
-                set_pixel(dest);
-            }
+        int32_t const w[3] = {w0row, w1row, w2row};
+        int32_t x0 = 0;
+        int32_t x1 = triangle_bounds.w - 1;
 
-            dest.x++;
+        for (int i = 0; i < 3; i++) {
+            if (a[i] > 0) {
+                // first x with w + a * x >= 0
+                x0 = std::max(x0, w[i] >= 0 ? 0 : (-w[i] + a[i] - 1) / a[i]);
+            } else if (a[i] < 0) {
+                // last x with w + a * x >= 0
+                x1 = std::min(x1, w[i] >= 0 ? w[i] / -a[i] : -1);
+            } else if (w[i] < 0) {
+                x1 = -1;
+            }
+        }
 
-            w0 += a12;
-            w1 += a20;
-            w2 += a01;
+        if (x0 <= x1) {
+            set_pixel_span(Point(triangle_bounds.x + x0, triangle_bounds.y + y), x1 - x0 + 1);
         }
 
         w0row += b12;
@@ -244,54 +685,145 @@ void PicoGraphics::triangle(Point p1, Point p2, Point p3) {
 }
 
 void PicoGraphics::polygon(const std::vector<Point> & points) {
-    static int32_t nodes[64]; // maximum allowed number of nodes per scanline for polygon rendering
+    fill_polygon(&points, 1, FILL_EVEN_ODD);
+}
 
-    int32_t miny = points[0].y, maxy = points[0].y;
+void PicoGraphics::polygon(const std::vector<std::vector<Point>> & contours, FillRule rule) {
+    fill_polygon(contours.data(), contours.size(), rule);
+}
 
-    for (uint16_t i = 1; i < points.size(); i++) {
-        miny = std::min(miny, points[i].y);
-        maxy = std::max(maxy, points[i].y);
+// floor(n / d) for d > 0
+static int32_t floor_div(int32_t n, int32_t d) {
+    return n >= 0 ? n / d : -((-n + d - 1) / d);
+}
+
+void PicoGraphics::fill_polygon(const std::vector<Point> * contours, size_t count, FillRule rule) {
+    PERF_SCOPE(PERF_RENDER);
+
+    typedef PolygonEdge Edge;
+    std::vector<Edge> & edges = polygon_edges;
+    edges.clear();
+    int32_t minx = INT32_MAX, maxx = INT32_MIN, miny = INT32_MAX, maxy = INT32_MIN;
+
+    for (size_t c = 0; c < count; c++) {
+        const std::vector<Point> & points = contours[c];
+        for (size_t i = 0; i < points.size(); i++) {
+            const Point & p = points[i];
+            const Point & q = points[(i + 1) % points.size()];
+            minx = std::min(minx, p.x);
+            maxx = std::max(maxx, p.x);
+            miny = std::min(miny, p.y);
+            maxy = std::max(maxy, p.y);
+            if (p.y == q.y) continue;
+
+            const Point & top = p.y < q.y ? p : q;
+            const Point & bottom = p.y < q.y ? q : p;
+            int32_t const h = bottom.y - top.y;
+            int32_t const step = floor_div(bottom.x - top.x, h);
+            edges.push_back({top.x, top.y, bottom.y, step, bottom.x - top.x - step * h, h, 0, 0, p.y < q.y ? 1 : -1});
+        }
     }
+    if (edges.empty()) return;
 
-    // for each scanline within the polygon bounds (clipped to clip rect)
-    Point p;
+    if (track_damage) mark_damage(Rect(minx, miny, maxx - minx + 1, maxy - miny + 1).intersection(clip));
 
-    for (p.y = std::max(clip.y, miny); p.y <= std::min(clip.y + clip.h, maxy); p.y++) {
-        uint8_t n = 0;
-        for (uint16_t i = 0; i < points.size(); i++) {
-            uint16_t j = (i + 1) % points.size();
-            int32_t sy = points[i].y;
-            int32_t ey = points[j].y;
-            int32_t fy = p.y;
-            if ((sy < fy && ey >= fy) || (ey < fy && sy >= fy)) {
-                int32_t sx = points[i].x;
-                int32_t ex = points[j].x;
-                int32_t px = int32_t(sx + float(fy - sy) / float(ey - sy) * float(ex - sx));
+    // the edge table, in the order edges become active
+    std::sort(edges.begin(), edges.end(), [](const Edge & a, const Edge & b) { return a.top_y < b.top_y; });
 
-                nodes[n++] = px < clip.x ? clip.x : (px >= clip.x + clip.w ? clip.x + clip.w - 1
-                                                                           : px);// clamp(int32_t(sx + float(fy - sy) / float(ey - sy) * float(ex - sx)), clip.x, clip.x + clip.w);
-            }
+    std::vector<Edge *> & active = polygon_active;
+    active.clear();
+    size_t next = 0;
+    int32_t const clip_r = clip.x + clip.w - 1;
+
+    // Spans include both ends, and the next span can start on the x the last one ended, so each
+    // starts past what the row has drawn or blending would show the pixel twice
+    int32_t drawn = 0;
+    auto span = [this, clip_r, &drawn](int32_t x0, int32_t x1, int32_t y) {
+        x0 = std::max(x0, drawn);
+        x1 = std::min(x1, clip_r);
+        if (x0 <= x1) {
+            set_pixel_span(Point(x0, y), x1 - x0 + 1);
+            drawn = x1 + 1;
         }
+    };
 
-        uint16_t i = 0;
-        while (i < n - 1) {
-            if (nodes[i] > nodes[i + 1]) {
-                int32_t s = nodes[i];
-                nodes[i] = nodes[i + 1];
-                nodes[i + 1] = s;
-                if (i) i--;
-            } else {
-                i++;
+    int32_t const y_end = std::min(maxy, clip.y + clip.h - 1);
+    for (int32_t y = std::max(miny + 1, clip.y); y <= y_end; y++) {
+        // retire edges that ended on the row above and bring in the ones crossing this row, starting
+        // them part way down if they began above the clip
+        active.erase(std::remove_if(active.begin(), active.end(), [y](const Edge * e) { return e->bottom_y < y; }),
+                     active.end());
+        for (; next < edges.size() && edges[next].top_y < y; next++) {
+            Edge & e = edges[next];
+            if (e.bottom_y < y) continue;
+            int32_t const rows = y - e.top_y;
+            int32_t const rem = e.step_rem * rows;
+            e.x = e.top_x + e.step * rows + rem / e.h;
+            e.rem = rem % e.h;
+            active.push_back(&e);
+        }
+
+        // stepping keeps the active edges nearly sorted, so insertion sort is close to linear
+        for (size_t i = 1; i < active.size(); i++) {
+            Edge * e = active[i];
+            size_t j = i;
+            for (; j > 0 && active[j - 1]->x > e->x; j--) active[j] = active[j - 1];
+            active[j] = e;
+        }
+
+        drawn = clip.x;
+        if (rule == FILL_EVEN_ODD) {
+            for (size_t i = 0; i + 1 < active.size(); i += 2) {
+                span(active[i]->x, active[i + 1]->x, y);
+            }
+        } else {
+            int32_t winding = 0;
+            int32_t start = 0;
+            for (Edge * e: active) {
+                if (winding == 0) start = e->x;
+                winding += e->dir;
+                if (winding == 0) span(start, e->x, y);
             }
         }
 
-        for (uint16_t i = 0; i < n; i += 2) {
-            pixel_span(Point(nodes[i], p.y), nodes[i + 1] - nodes[i] + 1);
+        for (Edge * e: active) {
+            e->x += e->step;
+            e->rem += e->step_rem;
+            if (e->rem >= e->h) {
+                e->x++;
+                e->rem -= e->h;
+            }
         }
     }
 }
 
+// Narrow the steps [i0, i1] to those where a + i * b lies within [lo, hi]
+static void clip_steps(int64_t a, int64_t b, int64_t lo, int64_t hi, int32_t & i0, int32_t & i1) {
+    if (b == 0) {
+        if (a < lo || a > hi) i1 = i0 - 1;
+        return;
+    }
+    if (b < 0) {
+        a = -a;
+        b = -b;
+        std::swap(lo, hi);
+        lo = -lo;
+        hi = -hi;
+    }
+    int64_t const n0 = lo - a;
+    int64_t const n1 = hi - a;
+    i0 = std::max<int64_t>(i0, n0 >= 0 ? (n0 + b - 1) / b : -(-n0 / b));
+    i1 = std::min<int64_t>(i1, n1 >= 0 ? n1 / b : -((-n1 + b - 1) / b));
+}
+
 void PicoGraphics::line(Point p1, Point p2) {
+    PERF_SCOPE(PERF_RENDER);
+    if (track_damage) {
+        Rect line_bounds(std::min(p1.x, p2.x), std::min(p1.y, p2.y),
+                         std::abs(p2.x - p1.x) + 1, std::abs(p2.y - p1.y) + 1);
+        mark_damage(line_bounds.intersection(clip));
+    }
+
     // fast horizontal line
     if (p1.y == p2.y) {
         int32_t start = std::min(p1.x, p2.x);
@@ -300,79 +832,407 @@ void PicoGraphics::line(Point p1, Point p2) {
         return;
     }
 
-    // fast vertical line
-    if (p1.x == p2.x) {
-        int32_t start = std::min(p1.y, p2.y);
-        int32_t length = std::max(p1.y, p2.y) - start;
-        Point dest(p1.x, start);
-        while (length--) {
-            pixel(dest);
-            dest.y++;
+    // vertical lines are drawn downwards from the top end
+    if (p1.x == p2.x && p1.y > p2.y) std::swap(p1, p2);
+
+    // Lines are stepped along their major axis, one pixel per step from p1 up to but not including
+    // p2, with the minor axis in fixed 16:16. The steps that land inside the clip are found up
+    // front so the pixels can be written without checks.
+    int32_t const dx = p2.x - p1.x;
+    int32_t const dy = p2.y - p1.y;
+    bool const shallow = std::abs(dx) > std::abs(dy);
+    int32_t const s = shallow ? std::abs(dx) : std::abs(dy);             // number of steps
+    int32_t const major_step = (shallow ? dx : dy) < 0 ? -1 : 1;
+    int32_t const minor_step = ((shallow ? dy : dx) << 16) / s;          // fixed 16:16
+    int32_t const major = shallow ? p1.x : p1.y;
+    int32_t const minor = (shallow ? p1.y : p1.x) << 16;
+
+    Rect const major_clip = shallow ? clip : Rect(clip.y, clip.x, clip.h, clip.w);
+    int32_t i0 = 0;
+    int32_t i1 = s - 1;
+    clip_steps(major, major_step, major_clip.x, major_clip.x + major_clip.w - 1, i0, i1);
+    clip_steps(minor, minor_step, int64_t(major_clip.y) << 16, (int64_t(major_clip.y + major_clip.h) << 16) - 1, i0, i1);
+    if (i0 > i1) return;
+
+    int32_t m = major + i0 * major_step;
+    int32_t acc = minor + int32_t(int64_t(i0) * minor_step);
+
+    if (shallow) {
+        // consecutive steps on the same row are one span
+        for (int32_t i = i0; i <= i1;) {
+            int32_t const y = acc >> 16;
+            int32_t const x = m;
+            int32_t n = 0;
+            do {
+                acc += minor_step;
+                m += major_step;
+                n++;
+                i++;
+            } while (i <= i1 && (acc >> 16) == y);
+            set_pixel_span(Point(major_step > 0 ? x : m + 1, y), n);
+        }
+    } else {
+        for (int32_t i = i0; i <= i1; i++) {
+            set_pixel(Point(acc >> 16, m));
+            acc += minor_step;
+            m += major_step;
+        }
+    }
+}
+
+static uint32_t isqrt(uint64_t n) {
+    if (n == 0) return 0;
+    uint64_t root = 0;
+    uint64_t bit = uint64_t(1) << ((63 - __builtin_clzll(n)) & ~1);  // highest power of four <= n
+    while (bit) {
+        if (n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+// unit circle used for round joins, in 16.16 fixed point. It runs counter-clockwise on screen, as y
+// is down, which is the same way round as the segment quads.
+static const int32_t join_circle[12][2] = {
+        {65536,  0},      {56756,  -32768}, {32768,  -56756},
+        {0,      -65536}, {-32768, -56756}, {-56756, -32768},
+        {-65536, 0},      {-56756, 32768},  {-32768, 56756},
+        {0,      65536},  {32768,  56756},  {56756,  32768}
+};
+
+// Offset a point by a 16.16 unit vector scaled to half the thickness, rounded down. Rows of a polygon
+// cover (top, bottom] and columns [left, right], so x is offset by (thickness - 1) / 2 and y by
+// thickness / 2 to make an axis aligned line exactly thickness pixels across.
+static Point thick_offset(const Point & p, int32_t nx, int32_t ny, int32_t thickness) {
+    return Point(p.x + int32_t((int64_t(nx) * (thickness - 1)) >> 17),
+                 p.y + int32_t((int64_t(ny) * thickness) >> 17));
+}
+
+// Whether line(p1, p2) draws its end p, given it leaves out the right end of horizontal lines, the
+// bottom end of vertical ones and p2 of the rest
+static bool line_draws_end(Point p1, Point p2, Point p) {
+    if (p1.y == p2.y) return p.x == std::min(p1.x, p2.x);
+    if (p1.x == p2.x) return p.y == std::min(p1.y, p2.y);
+    return p.x == p1.x && p.y == p1.y;
+}
+
+void PicoGraphics::thick_line(Point p1, Point p2, int32_t thickness) {
+    polyline({p1, p2}, thickness);
+}
+
+void PicoGraphics::polyline(const std::vector<Point> & points, int32_t thickness) {
+    if (points.empty()) return;
+
+    if (thickness <= 1) {
+        // line() leaves out one end, which is not always the one the next line starts from, so the
+        // vertices neither of their lines draw are plotted on their own
+        for (size_t i = 1; i < points.size(); i++) {
+            line(points[i - 1], points[i]);
+        }
+        // a repeated vertex is one pixel between the lines either side of the repeats, and the end
+        // of a closed polyline is one pixel with its start
+        size_t first = 1;
+        while (first < points.size() && points[first] == points[0]) first++;
+        bool const closed = first < points.size() && points.back() == points[0];
+        for (size_t i = closed ? first : 0, j; i < points.size(); i = j) {
+            for (j = i + 1; j < points.size() && points[j] == points[i]; j++) {}
+            bool const before = i > 0 && line_draws_end(points[i - 1], points[i], points[i]);
+            bool const after = j < points.size() ? line_draws_end(points[j - 1], points[j], points[i])
+                                                 : closed && line_draws_end(points[0], points[first], points[i]);
+            if (!before && !after) pixel(points[i]);
         }
         return;
     }
 
+    // Every segment is a quad and every inner corner a round join, all wound the same way and filled
+    // in one go with the non-zero rule, so the overlaps are only drawn once
+    std::vector<std::vector<Point>> contours;
+    for (size_t i = 1; i < points.size(); i++) {
+        const Point & a = points[i - 1];
+        const Point & b = points[i];
+        int64_t const dx = b.x - a.x;
+        int64_t const dy = b.y - a.y;
+        if (dx == 0 && dy == 0) continue;
 
-    // general purpose line
-    // lines are either "shallow" or "steep" based on whether the x delta
-    // is greater than the y delta
-    int32_t dx = p2.x - p1.x;
-    int32_t dy = p2.y - p1.y;
-    bool shallow = std::abs(dx) > std::abs(dy);
-    if (shallow) {
-        // shallow version
-        int32_t s = std::abs(dx);       // number of steps
-        int32_t sx = dx < 0 ? -1 : 1;   // x step value
-        int32_t sy = (dy << 16) / s;    // y step value in fixed 16:16
-        int32_t x = p1.x;
-        int32_t y = p1.y << 16;
-        while (s--) {
-            Point p(x, y >> 16);
-            pixel(p);
-            y += sy;
-            x += sx;
+        // the length has 8 fractional bits, so the unit normal divides out to 16 without floats
+        int64_t const len = isqrt(uint64_t(dx * dx + dy * dy) << 16);
+        int32_t const nx = int32_t(-dy * 16777216 / len);
+        int32_t const ny = int32_t(dx * 16777216 / len);
+        contours.push_back({thick_offset(a, nx, ny, thickness), thick_offset(b, nx, ny, thickness),
+                            thick_offset(b, -nx, -ny, thickness), thick_offset(a, -nx, -ny, thickness)});
+
+        if (i + 1 < points.size()) {
+            std::vector<Point> join;
+            for (auto & v: join_circle) join.push_back(thick_offset(b, v[0], v[1], thickness));
+            contours.push_back(join);
         }
-    } else {
-        // steep version
-        int32_t s = std::abs(dy);       // number of steps
-        int32_t sy = dy < 0 ? -1 : 1;   // y step value
-        int32_t sx = (dx << 16) / s;    // x step value in fixed 16:16
-        int32_t y = p1.y;
-        int32_t x = p1.x << 16;
-        while (s--) {
-            Point p(x >> 16, y);
-            pixel(p);
-            y += sy;
-            x += sx;
+    }
+    if (contours.empty()) {
+        // all the points are the same
+        contours.push_back({thick_offset(points[0], -65536, -65536, thickness), thick_offset(points[0], 65536, -65536, thickness),
+                            thick_offset(points[0], 65536, 65536, thickness), thick_offset(points[0], -65536, 65536, thickness)});
+    }
+
+    polygon(contours, FILL_NON_ZERO);
+}
+
+void PicoGraphics::line_aa(Point p1, Point p2) {
+    PERF_SCOPE(PERF_RENDER);
+    int32_t const dx = p2.x - p1.x;
+    int32_t const dy = p2.y - p1.y;
+    if (dx == 0 && dy == 0) return;
+
+    if (track_damage) {
+        Rect line_bounds(std::min(p1.x, p2.x), std::min(p1.y, p2.y), std::abs(dx) + 2, std::abs(dy) + 2);
+        mark_damage(line_bounds.intersection(clip));
+    }
+
+    // Stepped like line(), but each step covers the two pixels either side of the exact minor
+    // position, weighted by how close it is to each (Wu's algorithm)
+    bool const shallow = std::abs(dx) > std::abs(dy);
+    int32_t const s = shallow ? std::abs(dx) : std::abs(dy);
+    int32_t const major_step = (shallow ? dx : dy) < 0 ? -1 : 1;
+    int32_t const minor_step = ((shallow ? dy : dx) << 16) / s;
+    int32_t const major = shallow ? p1.x : p1.y;
+    int32_t const minor = (shallow ? p1.y : p1.x) << 16;
+
+    Rect const major_clip = shallow ? clip : Rect(clip.y, clip.x, clip.h, clip.w);
+    int32_t const minor_lo = major_clip.y;
+    int32_t const minor_hi = major_clip.y + major_clip.h - 1;
+    int32_t i0 = 0;
+    int32_t i1 = s - 1;
+    clip_steps(major, major_step, major_clip.x, major_clip.x + major_clip.w - 1, i0, i1);
+    clip_steps(minor, minor_step, int64_t(minor_lo - 1) << 16, (int64_t(minor_hi + 1) << 16) - 1, i0, i1);
+    if (i0 > i1) return;
+
+    int32_t m = major + i0 * major_step;
+    int32_t acc = minor + int32_t(int64_t(i0) * minor_step);
+
+    for (int32_t i = i0; i <= i1; i++) {
+        int32_t const n = acc >> 16;
+        uint8_t const f = (acc >> 8) & 0xff;
+        if (n >= minor_lo) set_pixel_alpha(shallow ? Point(m, n) : Point(n, m), 255 - f);
+        if (f && n < minor_hi) set_pixel_alpha(shallow ? Point(m, n + 1) : Point(n + 1, m), f);
+        acc += minor_step;
+        m += major_step;
+    }
+}
+
+void PicoGraphics::polyline_aa(const std::vector<Point> & points) {
+    if (points.empty()) return;
+
+    for (size_t i = 1; i < points.size(); i++) {
+        line_aa(points[i - 1], points[i]);
+    }
+    pixel(points.back());
+}
+
+void PicoGraphics::circle_outline_aa(const Point & p, int32_t radius) {
+    PERF_SCOPE(PERF_RENDER);
+    if (radius < 0) return;
+
+    Rect const circle_bounds(p.x - radius - 1, p.y - radius - 1, radius * 2 + 3, radius * 2 + 3);
+    if (!circle_bounds.intersects(clip)) return;
+    if (track_damage) mark_damage(circle_bounds.intersection(clip));
+
+    auto plot = [&](int32_t x, int32_t y, uint8_t alpha) {
+        Point const q(p.x + x, p.y + y);
+        if (alpha && clip.contains(q)) set_pixel_alpha(q, alpha);
+    };
+
+    // mirrored into all eight octants, without plotting a pixel twice on the axes and diagonals
+    auto plot8 = [&](int32_t x, int32_t y, uint8_t alpha) {
+        plot(x, y, alpha);
+        plot(x, -y, alpha);
+        if (x) {
+            plot(-x, y, alpha);
+            plot(-x, -y, alpha);
+        }
+        if (x != y) {
+            plot(y, x, alpha);
+            plot(-y, x, alpha);
+            if (x) {
+                plot(y, -x, alpha);
+                plot(-y, -x, alpha);
+            }
         }
+    };
+
+    // The octant below the top of the circle crosses each column once, at y = sqrt(r^2 - x^2) which
+    // is found with 8 fractional bits and shared between the pixels either side
+    uint64_t const r2 = uint64_t(radius) * radius << 16;
+    for (int32_t x = 0;; x++) {
+        // a radius of 0 is past the octant after its centre, before x > y is
+        uint64_t const x2 = uint64_t(x) * x << 16;
+        if (x2 > r2) break;
+        uint32_t const v = isqrt(r2 - x2);
+        int32_t const y = v >> 8;
+        if (x > y) break;
+
+        uint8_t const f = v & 0xff;
+        plot8(x, y, 255 - f);
+        plot8(x, y + 1, f);
     }
 }
 
 // Common function for frame buffer conversion to 565 pixel format
-void PicoGraphics::frame_convert_rgb565(conversion_callback_func callback, next_pixel_func get_next_pixel) {
-    // Allocate two temporary buffers, as the callback may transfer by DMA
-    // while we're preparing the next part of the row
-    const int BUF_LEN = 64;
-    uint16_t row_buf[2][BUF_LEN];
+void PicoGraphics::frame_convert_rgb565(conversion_callback_func callback) {
+    // Use two buffers, as the callback may transfer by DMA
+    // while we're converting the next chunk
+    if (convert_buffer.size() != convert_chunk * 2) {
+        convert_buffer.resize(convert_chunk * 2);
+    }
+    RGB565 * buf[2] = {&convert_buffer[0], &convert_buffer[convert_chunk]};
     int buf_idx = 0;
-    int buf_entry = 0;
-    for (auto i = 0; i < bounds.w * bounds.h; i++) {
-        row_buf[buf_idx][buf_entry] = get_next_pixel();
-        buf_entry++;
+
+    uint32_t const pixels = bounds.w * bounds.h;
+    for (uint32_t offset = 0; offset < pixels; offset += convert_chunk) {
+        uint32_t const count = std::min(convert_chunk, pixels - offset);
+        {
+            PERF_SCOPE(PERF_CONVERT);
+            convert_rgb565(offset, count, buf[buf_idx]);
+        }
 
         // Transfer a filled buffer and swap to the next one
-        if (buf_entry == BUF_LEN) {
-            callback(row_buf[buf_idx], BUF_LEN * sizeof(RGB565));
-            buf_idx ^= 1;
-            buf_entry = 0;
+        callback(buf[buf_idx], count * sizeof(RGB565));
+        buf_idx ^= 1;
+    }
+
+    // Callback with zero length to ensure previous buffer is fully written
+    callback(buf[buf_idx], 0);
+}
+
+#if PICO_GRAPHICS_INTERP
+// Sets up both interpolators of this core so that after writing a source word shifted up by
+// entry_shift to interp0 and the word itself to interp1, the four PEEKs are the addresses of the
+// entries for its four bytes, lowest first. The state is saved for whoever was using them.
+static void interp_lut8_begin(const void * lut, uint entry_shift, interp_hw_save_t * saved) {
+    interp_save(interp0, &saved[0]);
+    interp_save(interp1, &saved[1]);
+
+    for (uint lane = 0; lane < 2; lane++) {
+        interp_config config = interp_default_config();
+        interp_config_set_mask(&config, entry_shift, entry_shift + 7);
+        interp_config_set_cross_input(&config, lane == 1);  // both lanes look at accum0
+
+        interp_config_set_shift(&config, lane * 8);
+        interp_set_config(interp0, lane, &config);
+        interp_config_set_shift(&config, 16 + lane * 8 - entry_shift);
+        interp_set_config(interp1, lane, &config);
+
+        interp0->base[lane] = (uintptr_t) lut;
+        interp1->base[lane] = (uintptr_t) lut;
+    }
+}
+
+static void interp_lut8_end(interp_hw_save_t * saved) {
+    interp_restore(interp0, &saved[0]);
+    interp_restore(interp1, &saved[1]);
+}
+#endif
+
+void PicoGraphics::convert_lut8_rgb565(const uint8_t * src, uint32_t count, RGB565 * dst, const RGB565 * lut) {
+    // convert single pixels until the source is word aligned
+    while (count && ((uintptr_t) src & 0b11)) {
+        *dst++ = lut[*src++];
+        count--;
+    }
+
+    auto src32 = (const uint32_t *) src;
+    if (((uintptr_t) dst & 0b11) == 0) {
+        // four pixels per word read, written as two packed pairs
+        auto dst32 = (uint32_t *) dst;
+#if PICO_GRAPHICS_INTERP
+        interp_hw_save_t saved[2];
+        interp_lut8_begin(lut, 1, saved);
+        for (; count >= 4; count -= 4) {
+            uint32_t const c = *src32++;
+            interp0->accum[0] = c << 1;
+            interp1->accum[0] = c;
+            dst32[0] = *(const RGB565 *) interp0->peek[0] | (*(const RGB565 *) interp0->peek[1] << 16);
+            dst32[1] = *(const RGB565 *) interp1->peek[0] | (*(const RGB565 *) interp1->peek[1] << 16);
+            dst32 += 2;
+        }
+        interp_lut8_end(saved);
+#else
+        for (; count >= 4; count -= 4) {
+            uint32_t const c = *src32++;
+            dst32[0] = lut[c & 0xff] | (lut[(c >> 8) & 0xff] << 16);
+            dst32[1] = lut[(c >> 16) & 0xff] | (lut[c >> 24] << 16);
+            dst32 += 2;
+        }
+#endif
+        dst = (RGB565 *) dst32;
+    } else {
+        for (; count >= 4; count -= 4) {
+            uint32_t const c = *src32++;
+            dst[0] = lut[c & 0xff];
+            dst[1] = lut[(c >> 8) & 0xff];
+            dst[2] = lut[(c >> 16) & 0xff];
+            dst[3] = lut[c >> 24];
+            dst += 4;
         }
     }
+    src = (const uint8_t *) src32;
 
-    // Transfer any remaining pixels ( < BUF_LEN )
-    if (buf_entry > 0) {
-        callback(row_buf[buf_idx], buf_entry * sizeof(RGB565));
+    while (count--) {
+        *dst++ = lut[*src++];
     }
+}
 
-    // Callback with zero length to ensure previous buffer is fully written
-    callback(row_buf[buf_idx], 0);
+void PicoGraphics::convert_lut8_words(const uint32_t * src, uint32_t count, uint32_t * dst, const uint32_t * lut) {
+#if PICO_GRAPHICS_INTERP
+    interp_hw_save_t saved[2];
+    interp_lut8_begin(lut, 2, saved);
+    while (count--) {
+        uint32_t const c = *src++;
+        interp0->accum[0] = c << 2;
+        interp1->accum[0] = c;
+        dst[0] = *(const uint32_t *) interp0->peek[0];
+        dst[1] = *(const uint32_t *) interp0->peek[1];
+        dst[2] = *(const uint32_t *) interp1->peek[0];
+        dst[3] = *(const uint32_t *) interp1->peek[1];
+        dst += 4;
+    }
+    interp_lut8_end(saved);
+#else
+    while (count--) {
+        uint32_t const c = *src++;
+        dst[0] = lut[c & 0xff];
+        dst[1] = lut[(c >> 8) & 0xff];
+        dst[2] = lut[(c >> 16) & 0xff];
+        dst[3] = lut[c >> 24];
+        dst += 4;
+    }
+#endif
+}
+
+void PicoGraphics::fill_span_1bpp(uint8_t * row, uint32_t x, uint32_t l, uint8_t pattern) {
+    if (l == 0) return;
+
+    uint8_t * f = &row[x / 8];
+    uint32_t const last = x + l - 1;
+    uint32_t const bytes = (last / 8) - (x / 8);
+
+    uint8_t const head = 0xff >> (x & 0b111);         // first pixel to the end of its byte
+    uint8_t const tail = 0xff << (7 - (last & 0b111));  // start of the byte to the last pixel
+
+    if (bytes == 0) {
+        uint8_t const m = head & tail;
+        *f = (*f & ~m) | (pattern & m);
+        return;
+    }
+
+    *f = (*f & ~head) | (pattern & head);
+    f++;
+
+    memset(f, pattern, bytes - 1);
+    f += bytes - 1;
+
+    *f = (*f & ~tail) | (pattern & tail);
 }
\ No newline at end of file
@@ -9,6 +9,12 @@
 
 #include "pimoroni_common.hpp"
 
+// Look up palette and RGB332 colours with addresses from the SIO interpolators, the host build
+// uses the plain C++ loops which give the same output
+#ifndef PICO_GRAPHICS_INTERP
+#define PICO_GRAPHICS_INTERP PICO_ON_DEVICE
+#endif
+
 // A tiny graphics library for our Pico products
 // supports:
 //   - 16-bit (565) RGB
@@ -180,6 +186,16 @@ struct Rect {
     void deflate(int32_t v);
 };
 
+// A run of l pixels from p, along a row or down a column
+struct Span {
+    Point p;
+    int32_t l = 0;
+
+    Span() = default;
+
+    Span(const Point & p, int32_t l) : p(p), l(l) {}
+};
+
 static const RGB565 rgb332_to_rgb565_lut[256] = {
         0x0000, 0x0800, 0x1000, 0x1800, 0x0001, 0x0801, 0x1001, 0x1801, 0x0002, 0x0802, 0x1002, 0x1802, 0x0003, 0x0803,
         0x1003, 0x1803,
@@ -221,6 +237,7 @@ class PicoGraphics {
 public:
     enum PenType {
         PEN_1BIT,
+        PEN_1BIT_Y,
         PEN_3BIT,
         PEN_P2,
         PEN_P4,
@@ -228,6 +245,33 @@ public:
         PEN_RGB332,
         PEN_RGB565,
         PEN_RGB888,
+        PEN_DISPLAY_LIST,
+    };
+
+    // how polygon() decides what is inside where contours overlap or cross themselves
+    enum FillRule {
+        FILL_EVEN_ODD,  // inside where a ray crosses an odd number of edges
+        FILL_NON_ZERO,  // inside where the edges crossed don't cancel out by direction
+    };
+
+    // how pens that can blend combine the pen with what is already drawn, see set_blend()
+    enum BlendMode {
+        BLEND_NORMAL,    // mix by alpha
+        BLEND_ADD,       // add the pen scaled by alpha, saturating
+        BLEND_MULTIPLY,  // multiply by the pen, mixed in by alpha
+    };
+
+    // Pixels for blit(), laid out as in the framebuffer of a PEN_1BIT, PEN_P4, PEN_P8, PEN_RGB332,
+    // PEN_RGB565 or PEN_RGB888 pen but with stride bytes per row
+    struct Bitmap {
+        PenType format;
+        const void * data;
+        uint16_t width, height;
+        uint32_t stride;
+        const RGB * palette = nullptr;   // P4 and P8 colours, unless drawn to a pen of the same type
+        int32_t transparent = -1;        // pixel value that isn't drawn, -1 for none
+        const uint8_t * mask = nullptr;  // 1 bit per pixel, MSB first, pixels with a 0 aren't drawn
+        uint32_t mask_stride = 0;
     };
 
     void * frame_buffer;
@@ -236,8 +280,30 @@ public:
     Rect bounds;
     Rect clip;
 
+    uint8_t blend_alpha = 255;
+    BlendMode blend_mode = BLEND_NORMAL;
+
+    // Regions drawn to since the last clear_damage(), kept when damage tracking is enabled. Damage is
+    // recorded as one bit per DAMAGE_TILE x DAMAGE_TILE pixel tile, so marking is cheap however many
+    // primitives are drawn, and get_damage() merges neighbouring dirty tiles back into rects.
+    static constexpr int32_t DAMAGE_TILE_SHIFT = 3;
+    static constexpr int32_t DAMAGE_TILE = 1 << DAMAGE_TILE_SHIFT;
+    bool track_damage = false;
+    std::vector<uint32_t> damage_tiles;  // tile rows, each padded to whole words
+    uint16_t damage_stride = 0;          // words per tile row
+
+    // Number of pixels converted per frame_convert() callback, see set_convert_chunk()
+    static constexpr uint32_t DEFAULT_CONVERT_CHUNK = 512;
+    uint32_t convert_chunk = DEFAULT_CONVERT_CHUNK;
+    std::vector<RGB565> convert_buffer;
+
+    // Clipped batches are handed to the pen this many at a time
+    static constexpr size_t BATCH_SIZE = 64;
+    std::vector<Span> batch_spans;
+    std::vector<Point> batch_points;
+
     typedef std::function<void(void * data, size_t length)> conversion_callback_func;
-    typedef std::function<RGB565()> next_pixel_func;
+    typedef std::function<void(const Rect & region)> damage_callback_func;
     //typedef std::function<void(int y)> scanline_interrupt_func;
 
     //scanline_interrupt_func scanline_interrupt = nullptr;
@@ -280,6 +346,8 @@ public:
 //      set_font(&font6);
     };
 
+    virtual ~PicoGraphics() = default;
+
     virtual void set_pen(uint c) = 0;
 
     virtual void set_pen(uint8_t r, uint8_t g, uint8_t b) = 0;
@@ -300,8 +368,24 @@ public:
 
     virtual void set_pixel_dither(const Point & p, const uint8_t & c);
 
+    // Blend the pen into a pixel by coverage from 0 (none) to 255 (all). Pens that can't blend set
+    // the pixel when at least half of it is covered.
+    virtual void set_pixel_alpha(const Point & p, uint8_t alpha);
+
+    // Batches of set_pixel(), set_pixel_span() and runs down a column, already clipped. The defaults
+    // draw them a pixel or span at a time, pens override them with tighter loops.
+    virtual void set_pixels(const Point * points, size_t count);
+
+    virtual void set_pixel_spans(const Span * spans, size_t count);
+
+    virtual void set_vertical_spans(const Span * spans, size_t count);
+
     virtual void frame_convert(PenType type, conversion_callback_func callback);
 
+    // Converts `count` pixels, starting `offset` pixels into the framebuffer, to RGB565 in `dst`
+    virtual void convert_rgb565(uint32_t offset, uint32_t count, RGB565 * dst);
+
+    // Draws an 8x8 tile of a 128x128 RGB332 sprite sheet with blit()
     virtual void sprite(void * data, const Point & sprite, const Point & dest, const int scale, const int transparent);
 
 //    void set_font(const bitmap::font_t *font);
@@ -312,39 +396,126 @@ public:
 
     void set_framebuffer(void * frame_buffer);
 
+    // Larger chunks amortise the per-callback (DMA setup) cost, at two chunks of RGB565 of memory
+    void set_convert_chunk(uint32_t pixels);
+
     void * get_data();
 
     void get_data(PenType type, uint y, void * row_buf);
 
-    void set_clip(const Rect & r);
+    void set_damage_tracking(bool enable);
 
-    void remove_clip();
+    void mark_damage(const Rect & r);
 
-    void clear();
+    void clear_damage();
 
-    void pixel(const Point & p);
+    bool has_damage() const;
 
-    void pixel_span(const Point & p, int32_t l);
+    // Calls back with non-overlapping rects that together cover all damage
+    void get_damage(damage_callback_func callback) const;
 
-    void rectangle(const Rect & r);
+    // The drawing primitives are virtual so a pen can record them instead, see PicoGraphics_PenDisplayList
+    virtual void set_clip(const Rect & r);
 
-    void circle(const Point & p, int32_t r);
+    virtual void remove_clip();
 
-    void character(const char c, const Point & p, float s = 2.0f, float a = 0.0f);
+    // Pen opacity from 0 to 255 and blend mode for the RGB565 pens, other pens always overwrite
+    virtual void set_blend(uint8_t alpha, BlendMode mode = BLEND_NORMAL);
 
-    void text(const std::string & t, const Point & p, int32_t wrap, float s = 2.0f, float a = 0.0f,
-              uint8_t letter_spacing = 1);
+    bool blending() const {
+        return blend_alpha != 255 || blend_mode != BLEND_NORMAL;
+    }
+
+    virtual void clear();
+
+    virtual void pixel(const Point & p);
+
+    virtual void pixel_span(const Point & p, int32_t l);
+
+    virtual void rectangle(const Rect & r);
+
+    virtual void circle(const Point & p, int32_t r);
+
+    virtual void character(const char c, const Point & p, float s = 2.0f, float a = 0.0f);
+
+    virtual void text(const std::string & t, const Point & p, int32_t wrap, float s = 2.0f, float a = 0.0f,
+                      uint8_t letter_spacing = 1);
 
     int32_t measure_text(const std::string & t, float s = 2.0f, uint8_t letter_spacing = 1);
 
-    void polygon(const std::vector<Point> & points);
+    virtual void polygon(const std::vector<Point> & points);
+
+    // Fill several contours as one shape, with the fill rule deciding whether overlaps are inside
+    virtual void polygon(const std::vector<std::vector<Point>> & contours, FillRule rule = FILL_EVEN_ODD);
+
+    virtual void triangle(Point p1, Point p2, Point p3);
+
+    virtual void line(Point p1, Point p2);
+
+    // Batches in the current pen, clipped together and passed to the pen a batch at a time rather
+    // than one primitive at a time
+    virtual void rectangles(const Rect * rects, size_t count);
+
+    virtual void pixels(const Point * points, size_t count);
+
+    virtual void pixel_spans(const Span * spans, size_t count);
 
-    void triangle(Point p1, Point p2, Point p3);
+    virtual void vertical_spans(const Span * spans, size_t count);
 
-    void line(Point p1, Point p2);
+    // Draw the src part of bitmap with its top left at dest, each pixel scale x scale. Runs of the
+    // same colour are drawn as spans using the pen, so the pen needs setting again afterwards.
+    virtual void blit(const Bitmap & bitmap, const Rect & src, const Point & dest, int32_t scale = 1);
+
+    // A line thickness pixels across with square ends
+    void thick_line(Point p1, Point p2, int32_t thickness);
+
+    // Lines joining up points, with round corners when thicker than a pixel
+    void polyline(const std::vector<Point> & points, int32_t thickness = 1);
+
+    // Anti-aliased line, leaving out p2 like line() does
+    virtual void line_aa(Point p1, Point p2);
+
+    // Anti-aliased lines joining up points
+    void polyline_aa(const std::vector<Point> & points);
+
+    // Anti-aliased outline of a circle
+    virtual void circle_outline_aa(const Point & p, int32_t r);
 
 protected:
-    void frame_convert_rgb565(conversion_callback_func callback, next_pixel_func get_next_pixel);
+    void frame_convert_rgb565(conversion_callback_func callback);
+
+    // Add a clipped span to batch_spans, passing the batch to the pen when full
+    void batch_span(const Span & span, bool vertical);
+
+    void flush_spans(bool vertical);
+
+    // Scanline fill of count contours from a sorted edge table, rows within the clip only
+    void fill_polygon(const std::vector<Point> * contours, size_t count, FillRule rule);
+
+    // An edge crosses the rows below its top vertex down to and including its bottom one. Its x is
+    // stepped a row at a time as whole pixels plus a remainder in 1/h of a pixel, which keeps it
+    // exactly on floor(x_top + (y - y_top) * w / h) without floats or rounding drift.
+    struct PolygonEdge {
+        int32_t top_x, top_y, bottom_y;
+        int32_t step, step_rem, h;  // w = step * h + step_rem, 0 <= step_rem < h
+        int32_t x, rem;
+        int32_t dir;                // +1 going down, -1 going up, for the non-zero rule
+    };
+
+    // fill_polygon()'s edge table and active edges, kept so fills don't allocate once they've grown
+    std::vector<PolygonEdge> polygon_edges;
+    std::vector<PolygonEdge *> polygon_active;
+
+    // Convert count 8-bit pixels through a 256 entry RGB565 lookup table, reading a word at a time
+    static void convert_lut8_rgb565(const uint8_t * src, uint32_t count, RGB565 * dst, const RGB565 * lut);
+
+    // Replace each byte of count words with its 32-bit entry in a 256 entry lookup table, four
+    // entries per source word
+    static void convert_lut8_words(const uint32_t * src, uint32_t count, uint32_t * dst, const uint32_t * lut);
+
+    // Set l pixels from x in a row of 1 bit per pixel (leftmost pixel in the MSB) from a repeating
+    // byte pattern, masking the ragged ends and filling whole bytes in between
+    static void fill_span_1bpp(uint8_t * row, uint32_t x, uint32_t l, uint8_t pattern);
 };
 
 class PicoGraphics_Pen1Bit : public PicoGraphics {
@@ -441,6 +612,9 @@ public:
     uint8_t color;
     RGB palette[palette_size];
     bool used[palette_size];
+    RGB565 palette_rgb565[palette_size];  // palette as RGB565, built by frame_convert()
+    uint32_t palette_rgb565_pairs[256];   // both pixels of a frame buffer byte as RGB565, first in the low half
+    bool palette_rgb565_built = false;    // cleared by update_pen(), create_pen() and reset_pen()
 
     std::array<std::array<uint8_t, 16>, 512> candidate_cache;
     bool cache_built = false;
@@ -468,6 +642,8 @@ public:
 
     void frame_convert(PenType type, conversion_callback_func callback) override;
 
+    void convert_rgb565(uint32_t offset, uint32_t count, RGB565 * dst) override;
+
     static size_t buffer_size(uint w, uint h) {
         return w * h / 2;
     }
@@ -479,6 +655,8 @@ public:
     uint8_t color;
     RGB palette[palette_size];
     bool used[palette_size];
+    RGB565 palette_rgb565[palette_size];  // palette as RGB565, built by frame_convert()
+    bool palette_rgb565_built = false;    // cleared by update_pen(), create_pen() and reset_pen()
 
     std::array<std::array<uint8_t, 16>, 512> candidate_cache;
     bool cache_built = false;
@@ -506,6 +684,8 @@ public:
 
     void frame_convert(PenType type, conversion_callback_func callback) override;
 
+    void convert_rgb565(uint32_t offset, uint32_t count, RGB565 * dst) override;
+
     static size_t buffer_size(uint w, uint h) {
         return w * h;
     }
@@ -531,10 +711,10 @@ public:
 
     void set_pixel_dither(const Point & p, const RGB565 & c) override;
 
-    void sprite(void * data, const Point & sprite, const Point & dest, const int scale, const int transparent) override;
-
     void frame_convert(PenType type, conversion_callback_func callback) override;
 
+    void convert_rgb565(uint32_t offset, uint32_t count, RGB565 * dst) override;
+
     static size_t buffer_size(uint w, uint h) {
         return w * h;
     }
@@ -557,9 +737,25 @@ public:
 
     void set_pixel_span(const Point & p, uint l) override;
 
+    void set_pixel_alpha(const Point & p, uint8_t alpha) override;
+
+    void set_pixels(const Point * points, size_t count) override;
+
+    void set_pixel_spans(const Span * spans, size_t count) override;
+
+    void set_vertical_spans(const Span * spans, size_t count) override;
+
+    void frame_convert(PenType type, conversion_callback_func callback) override;
+
+    void convert_rgb565(uint32_t offset, uint32_t count, RGB565 * dst) override;
+
     static size_t buffer_size(uint w, uint h) {
         return w * h * sizeof(RGB565);
     }
+
+protected:
+    // Blend the pen into l pixels from buf by alpha (0 - 255) with the blend mode
+    void blend_span(RGB565 * buf, uint l, uint8_t alpha);
 };
 
 
@@ -580,12 +776,139 @@ public:
 
     void set_pixel_span(const Point & p, uint l) override;
 
+    void set_pixel_alpha(const Point & p, uint8_t alpha) override;
+
+    void frame_convert(PenType type, conversion_callback_func callback) override;
+
+    void convert_rgb565(uint32_t offset, uint32_t count, RGB565 * dst) override;
+
+    // Mix src over dst by alpha (0 - 255)
+    static RGB888 blend(RGB888 dst, RGB888 src, uint8_t alpha);
+
     static size_t buffer_size(uint w, uint h) {
         return w * h * sizeof(uint32_t);
     }
 };
 
 
+
+// Records drawing calls into a display list instead of a framebuffer. frame_convert() to RGB565 then
+// rasterizes the list a band of rows at a time into one of two small band buffers, skipping
+// commands that don't touch the band, so a display driver can send one band while the next is drawn.
+// clear() with no clip set starts a new list, so a draw loop that clears every frame stays bounded.
+class PicoGraphics_PenDisplayList : public PicoGraphics_PenRGB565 {
+public:
+    enum CommandType : uint8_t {
+        CMD_SET_CLIP,
+        CMD_SET_BLEND,
+        CMD_CLEAR,
+        CMD_PIXEL,
+        CMD_PIXEL_SPAN,
+        CMD_RECTANGLE,
+        CMD_CIRCLE,
+        CMD_TEXT,
+        CMD_POLYGON,
+        CMD_TRIANGLE,
+        CMD_LINE,
+        CMD_LINE_AA,
+        CMD_CIRCLE_AA,
+        CMD_BLIT,
+    };
+
+    struct Command {
+        CommandType type;
+        RGB565 color;
+        int16_t y0, y1;  // rows touched, for culling
+        int16_t a[7];    // arguments, commands with any that don't fit aren't recorded
+        uint32_t pool;   // where the text, polygon or blit starts in its pool
+    };
+
+    uint16_t band_height;
+    std::vector<Command> commands;
+    std::vector<Point> points;  // polygons, each contour a Point(size, 0) followed by its points
+    std::string strings;        // text
+
+    struct BlitArgs {
+        Bitmap bitmap;
+        Rect src;
+        Point dest;
+        int32_t scale;
+    };
+    std::vector<BlitArgs> blits;  // the bitmaps themselves aren't copied, so must outlive the frame
+
+    PicoGraphics_PenDisplayList(uint16_t width, uint16_t height, uint16_t band_height = 16,
+                                void * band_buffer = nullptr);
+
+    void set_pixel(const Point & p) override;
+
+    void set_pixel_span(const Point & p, uint l) override;
+
+    void set_pixel_alpha(const Point & p, uint8_t alpha) override;
+
+    void set_pixels(const Point * points, size_t count) override;
+
+    void set_pixel_spans(const Span * spans, size_t count) override;
+
+    void set_vertical_spans(const Span * spans, size_t count) override;
+
+    void set_clip(const Rect & r) override;
+
+    void remove_clip() override;
+
+    void set_blend(uint8_t alpha, BlendMode mode = BLEND_NORMAL) override;
+
+    void clear() override;
+
+    void pixel(const Point & p) override;
+
+    void pixel_span(const Point & p, int32_t l) override;
+
+    void rectangle(const Rect & r) override;
+
+    void circle(const Point & p, int32_t r) override;
+
+    void character(const char c, const Point & p, float s = 2.0f, float a = 0.0f) override;
+
+    void text(const std::string & t, const Point & p, int32_t wrap, float s = 2.0f, float a = 0.0f,
+              uint8_t letter_spacing = 1) override;
+
+    void polygon(const std::vector<Point> & points) override;
+
+    void polygon(const std::vector<std::vector<Point>> & contours, FillRule rule = FILL_EVEN_ODD) override;
+
+    void triangle(Point p1, Point p2, Point p3) override;
+
+    void line(Point p1, Point p2) override;
+
+    void line_aa(Point p1, Point p2) override;
+
+    void circle_outline_aa(const Point & p, int32_t r) override;
+
+    void rectangles(const Rect * rects, size_t count) override;
+
+    void pixels(const Point * points, size_t count) override;
+
+    void pixel_spans(const Span * spans, size_t count) override;
+
+    void vertical_spans(const Span * spans, size_t count) override;
+
+    void blit(const Bitmap & bitmap, const Rect & src, const Point & dest, int32_t scale = 1) override;
+
+    void frame_convert(PenType type, conversion_callback_func callback) override;
+
+    // two bands of RGB565
+    static size_t buffer_size(uint w, uint band_height) {
+        return 2 * w * band_height * sizeof(RGB565);
+    }
+
+private:
+    bool replaying = false;
+    int32_t band_y = 0;  // first row of the band being rasterized
+    std::vector<std::vector<Point>> replay_contours;  // reused for every polygon replayed
+
+    bool record(CommandType type, int32_t y0, int32_t y1, std::initializer_list<int32_t> args, uint32_t pool = 0);
+};
+
 class DisplayDriver {
 public:
     uint16_t width;
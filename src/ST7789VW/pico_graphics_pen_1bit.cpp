@@ -42,13 +42,26 @@
     *f |= (_dc << bo);
   }
 
+  // the 4x4 ordered dither for one row as a byte of eight pixels, leftmost pixel in the MSB
+  static uint8_t dither_row_pattern(uint color, int32_t y) {
+    if(color == 0) return 0x00;
+    if(color >= 15) return 0xff;
+
+    uint8_t pattern = 0;
+    for(auto i = 0u; i < 4; i++) {
+      if(color > dither16_pattern[i | ((y & 0b11) << 2)]) {
+        pattern |= 0b10001000 >> i;
+      }
+    }
+    return pattern;
+  }
+
   void PicoGraphics_Pen1Bit::set_pixel_span(const Point &p, uint l) {
-    Point lp = p;
     if(p.x + (int)l >= bounds.w) {
       l = bounds.w - p.x;
     }
-    while(l--) {
-        set_pixel(lp);
-        lp.x++;
-    }
+
+    // pointer to the row in the framebuffer
+    uint8_t *buf = (uint8_t *)frame_buffer;
+    fill_span_1bpp(&buf[p.y * bounds.w / 8], p.x, l, dither_row_pattern(color, p.y));
   }
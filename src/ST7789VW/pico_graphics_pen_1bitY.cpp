@@ -3,7 +3,7 @@
 
   PicoGraphics_Pen1BitY::PicoGraphics_Pen1BitY(uint16_t width, uint16_t height, void *frame_buffer)
     : PicoGraphics(width, height, frame_buffer) {
-    this->pen_type = PEN_1BIT;
+    this->pen_type = PEN_1BIT_Y;
     if(this->frame_buffer == nullptr) {
       this->frame_buffer = (void *)(new uint8_t[buffer_size(width, height)]);
     }
@@ -14,7 +14,7 @@
   }
 
   void PicoGraphics_Pen1BitY::set_pen(uint8_t r, uint8_t g, uint8_t b) {
-    color = std::max(r, std::max(g, b));
+    color = std::max(r, std::max(g, b)) >> 4;
   }
 
   void PicoGraphics_Pen1BitY::set_pixel(const Point &p) {
@@ -22,7 +22,8 @@
     uint8_t *buf = (uint8_t *)frame_buffer;
     uint8_t *f = &buf[(p.y / 8) + (p.x * bounds.h / 8)];
 
-    uint bo = 7 - (p.y & 0b111);
+    // least significant bit at the top, as in SSD1306 display RAM
+    uint bo = p.y & 0b111;
 
     uint8_t _dc = 0;
 
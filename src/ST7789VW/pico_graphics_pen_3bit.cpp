@@ -13,6 +13,8 @@
         color = c & 0xf;
     }
     void PicoGraphics_Pen3Bit::set_pen(uint8_t r, uint8_t g, uint8_t b) {
+        int pen = RGB(r, g, b).closest(palette, palette_size);
+        if(pen != -1) color = pen;
     }
     void PicoGraphics_Pen3Bit::set_pixel(const Point &p) {
         uint offset = (bounds.w * bounds.h) / 8;
@@ -38,11 +40,14 @@
     }
 
     void PicoGraphics_Pen3Bit::set_pixel_span(const Point &p, uint l) {
-        Point lp = p;
-        while(l--) {
-            set_pixel(lp);
-            lp.x++;
-        }
+        uint offset = (bounds.w * bounds.h) / 8;
+        uint8_t *buf = (uint8_t *)frame_buffer;
+
+        // each plane gets a run of all set or all clear bits
+        uint8_t *rowA = &buf[p.y * bounds.w / 8];
+        fill_span_1bpp(rowA, p.x, l, (color & 0b100) ? 0xff : 0x00);
+        fill_span_1bpp(rowA + offset, p.x, l, (color & 0b010) ? 0xff : 0x00);
+        fill_span_1bpp(rowA + offset + offset, p.x, l, (color & 0b001) ? 0xff : 0x00);
     }
 
     void PicoGraphics_Pen3Bit::get_dither_candidates(const RGB &col, const RGB *palette, size_t len, std::array<uint8_t, 16> &candidates) {
@@ -91,27 +96,30 @@
     }
     void PicoGraphics_Pen3Bit::frame_convert(PenType type, conversion_callback_func callback) {
         if(type == PEN_P4) {
-            uint8_t row_buf[bounds.w / 2];
+            // spreads the 8 pixels of a plane byte to bit 0 of each nibble of 4 P4 bytes, first pixel in
+            // the high nibble of the lowest byte
+            static const auto spread = [] {
+                std::array<uint32_t, 256> table{};
+                for(auto i = 0u; i < 256; i++) {
+                    for(auto k = 0u; k < 8; k++) {
+                        if(i & (0b10000000 >> k)) {
+                            table[i] |= 1u << ((k / 2) * 8 + ((k & 0b1) ? 0 : 4));
+                        }
+                    }
+                }
+                return table;
+            }();
+
+            uint32_t row_buf[bounds.w / 8];
             uint offset = (bounds.w * bounds.h) / 8;
-            uint8_t *buf = (uint8_t *)frame_buffer;
+            uint8_t *bufA = (uint8_t *)frame_buffer;
+            uint8_t *bufB = bufA + offset;
+            uint8_t *bufC = bufB + offset;
 
+            // 8 pixels at a time, one byte from each plane
             for(auto y = 0; y < bounds.h; y++) {
-                for(auto x = 0; x < bounds.w; x++) {
-                    uint bo = 7 - (x & 0b111);
-
-                    uint8_t *bufA = &buf[(x / 8) + (y * bounds.w / 8)];
-                    uint8_t *bufB = bufA + offset;
-                    uint8_t *bufC = bufA + offset + offset;
-
-                    uint8_t nibble = (*bufA >> bo) & 1U;
-                    nibble <<= 1;
-                    nibble |= (*bufB >> bo) & 1U;
-                    nibble <<= 1;
-                    nibble |= (*bufC >> bo) & 1U;
-                    nibble <<= (x & 0b1) ? 0 : 4;
-
-                    row_buf[x / 2] &= (x & 0b1) ? 0b11110000 : 0b00001111;
-                    row_buf[x / 2] |= nibble;
+                for(auto i = 0; i < bounds.w / 8; i++) {
+                    row_buf[i] = (spread[*bufA++] << 2) | (spread[*bufB++] << 1) | spread[*bufC++];
                 }
                 callback(row_buf, bounds.w / 2);
             }
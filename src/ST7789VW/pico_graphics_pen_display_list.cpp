@@ -0,0 +1,302 @@
+#include "pico_graphics.hpp"
+#include <climits>
+#include "../perf/perf_counters.hpp"
+
+    PicoGraphics_PenDisplayList::PicoGraphics_PenDisplayList(uint16_t width, uint16_t height, uint16_t band_height, void *band_buffer)
+    : PicoGraphics_PenRGB565(width, height, band_buffer), band_height(band_height) {
+        this->pen_type = PEN_DISPLAY_LIST;
+        if(this->frame_buffer == nullptr) {
+            this->frame_buffer = (void *)(new uint8_t[buffer_size(width, band_height)]);
+        }
+    }
+
+    // only called while rasterizing, frame_buffer is then the current band
+    void PicoGraphics_PenDisplayList::set_pixel(const Point &p) {
+        uint16_t *buf = (uint16_t *)frame_buffer;
+        if(blending()) return blend_span(&buf[(p.y - band_y) * bounds.w + p.x], 1, blend_alpha);
+        buf[(p.y - band_y) * bounds.w + p.x] = color;
+    }
+    void PicoGraphics_PenDisplayList::set_pixel_span(const Point &p, uint l) {
+        uint16_t *buf = (uint16_t *)frame_buffer;
+        buf = &buf[(p.y - band_y) * bounds.w + p.x];
+        if(blending()) return blend_span(buf, l, blend_alpha);
+
+        while(l--) {
+            *buf++ = color;
+        }
+    }
+
+    void PicoGraphics_PenDisplayList::set_pixel_alpha(const Point &p, uint8_t alpha) {
+        uint16_t *buf = (uint16_t *)frame_buffer;
+        blend_span(&buf[(p.y - band_y) * bounds.w + p.x], 1, (alpha * blend_alpha + 255) >> 8);
+    }
+
+    // while rasterizing, the batches go a pixel or span at a time into the band
+    void PicoGraphics_PenDisplayList::set_pixels(const Point *points, size_t count) {
+        PicoGraphics::set_pixels(points, count);
+    }
+    void PicoGraphics_PenDisplayList::set_pixel_spans(const Span *spans, size_t count) {
+        PicoGraphics::set_pixel_spans(spans, count);
+    }
+    void PicoGraphics_PenDisplayList::set_vertical_spans(const Span *spans, size_t count) {
+        PicoGraphics::set_vertical_spans(spans, count);
+    }
+
+    bool PicoGraphics_PenDisplayList::record(CommandType type, int32_t y0, int32_t y1, std::initializer_list<int32_t> args, uint32_t pool) {
+        // nothing outside the clip is drawn, so cull against it as well
+        y0 = std::max(y0, clip.y);
+        y1 = std::min(y1, clip.y + clip.h - 1);
+        if(type != CMD_SET_CLIP && y0 > y1) return false;
+
+        // coordinates this far off screen would replay wrapped around, so aren't drawn at all
+        for(auto arg : args) {
+            if(arg < INT16_MIN || arg > INT16_MAX) return false;
+        }
+
+        Command command;
+        command.type = type;
+        command.color = color;
+        command.y0 = y0;
+        command.y1 = y1;
+        command.pool = pool;
+        auto i = 0u;
+        for(auto arg : args) command.a[i++] = arg;
+        commands.push_back(command);
+        return true;
+    }
+
+    void PicoGraphics_PenDisplayList::set_clip(const Rect &r) {
+        PicoGraphics::set_clip(r);
+        if(replaying) return;
+        commands.push_back({CMD_SET_CLIP, color, 0, 0, {int16_t(clip.x), int16_t(clip.y), int16_t(clip.w), int16_t(clip.h)}});
+    }
+    void PicoGraphics_PenDisplayList::remove_clip() {
+        PicoGraphics::remove_clip();
+        if(replaying) return;
+        commands.push_back({CMD_SET_CLIP, color, 0, 0, {int16_t(clip.x), int16_t(clip.y), int16_t(clip.w), int16_t(clip.h)}});
+    }
+    void PicoGraphics_PenDisplayList::set_blend(uint8_t alpha, BlendMode mode) {
+        PicoGraphics::set_blend(alpha, mode);
+        if(replaying) return;
+        commands.push_back({CMD_SET_BLEND, color, 0, 0, {alpha, int16_t(mode)}});
+    }
+
+    void PicoGraphics_PenDisplayList::clear() {
+        if(replaying) return PicoGraphics::clear();
+
+        // everything recorded so far is covered, start a new list
+        if(clip.x == bounds.x && clip.y == bounds.y && clip.w == bounds.w && clip.h == bounds.h) {
+            commands.clear();
+            points.clear();
+            strings.clear();
+            blits.clear();
+            if(blending()) commands.push_back({CMD_SET_BLEND, color, 0, 0, {blend_alpha, int16_t(blend_mode)}});
+        }
+        record(CMD_CLEAR, clip.y, clip.y + clip.h - 1, {});
+    }
+    void PicoGraphics_PenDisplayList::pixel(const Point &p) {
+        if(replaying) return PicoGraphics::pixel(p);
+        record(CMD_PIXEL, p.y, p.y, {p.x, p.y});
+    }
+    void PicoGraphics_PenDisplayList::pixel_span(const Point &p, int32_t l) {
+        if(replaying) return PicoGraphics::pixel_span(p, l);
+        // clipped here so spans of any length fit
+        int32_t const x0 = std::max(p.x, clip.x);
+        int32_t const x1 = std::min(p.x + l, clip.x + clip.w);
+        if(x1 > x0) record(CMD_PIXEL_SPAN, p.y, p.y, {x0, p.y, x1 - x0});
+    }
+    void PicoGraphics_PenDisplayList::rectangle(const Rect &r) {
+        if(replaying) return PicoGraphics::rectangle(r);
+        // clipped here so rectangles of any size fit
+        Rect const clipped = r.intersection(clip);
+        if(!clipped.empty()) record(CMD_RECTANGLE, clipped.y, clipped.y + clipped.h - 1, {clipped.x, clipped.y, clipped.w, clipped.h});
+    }
+    void PicoGraphics_PenDisplayList::circle(const Point &p, int32_t r) {
+        if(replaying) return PicoGraphics::circle(p, r);
+        record(CMD_CIRCLE, p.y - r, p.y + r, {p.x, p.y, r});
+    }
+    void PicoGraphics_PenDisplayList::character(const char c, const Point &p, float s, float a) {
+        if(replaying) return PicoGraphics::character(c, p, s, a);
+        text(std::string(1, c), p, 0, s, a, 0);
+    }
+    void PicoGraphics_PenDisplayList::text(const std::string &t, const Point &p, int32_t wrap, float s, float a, uint8_t letter_spacing) {
+        if(replaying) return PicoGraphics::text(t, p, wrap, s, a, letter_spacing);
+        // wrapping and newlines can take text anywhere below its first row
+        // no text is wide enough for a wrap past INT16_MAX to make a difference
+        wrap = std::min<int32_t>(wrap, INT16_MAX);
+        if(record(CMD_TEXT, p.y, bounds.h - 1, {int32_t(t.size()), p.x, p.y, wrap, int32_t(s), letter_spacing}, strings.size())) {
+            strings += t;
+        }
+    }
+    void PicoGraphics_PenDisplayList::polygon(const std::vector<Point> &pts) {
+        if(replaying) return PicoGraphics::polygon(pts);
+        polygon(std::vector<std::vector<Point>>{pts}, FILL_EVEN_ODD);
+    }
+    void PicoGraphics_PenDisplayList::polygon(const std::vector<std::vector<Point>> &contours, FillRule rule) {
+        if(replaying) return PicoGraphics::polygon(contours, rule);
+        int32_t miny = INT32_MAX, maxy = INT32_MIN;
+        for(auto &contour : contours) {
+            for(auto &p : contour) {
+                miny = std::min(miny, p.y);
+                maxy = std::max(maxy, p.y);
+            }
+        }
+        if(miny > maxy) return;
+        if(!record(CMD_POLYGON, miny, maxy, {int32_t(contours.size()), rule}, points.size())) return;
+        for(auto &contour : contours) {
+            points.push_back(Point(contour.size(), 0));
+            points.insert(points.end(), contour.begin(), contour.end());
+        }
+    }
+    void PicoGraphics_PenDisplayList::triangle(Point p1, Point p2, Point p3) {
+        if(replaying) return PicoGraphics::triangle(p1, p2, p3);
+        record(CMD_TRIANGLE, std::min({p1.y, p2.y, p3.y}), std::max({p1.y, p2.y, p3.y}), {p1.x, p1.y, p2.x, p2.y, p3.x, p3.y});
+    }
+    void PicoGraphics_PenDisplayList::line(Point p1, Point p2) {
+        if(replaying) return PicoGraphics::line(p1, p2);
+        record(CMD_LINE, std::min(p1.y, p2.y), std::max(p1.y, p2.y), {p1.x, p1.y, p2.x, p2.y});
+    }
+    void PicoGraphics_PenDisplayList::line_aa(Point p1, Point p2) {
+        if(replaying) return PicoGraphics::line_aa(p1, p2);
+        record(CMD_LINE_AA, std::min(p1.y, p2.y), std::max(p1.y, p2.y) + 1, {p1.x, p1.y, p2.x, p2.y});
+    }
+    void PicoGraphics_PenDisplayList::circle_outline_aa(const Point &p, int32_t r) {
+        if(replaying) return PicoGraphics::circle_outline_aa(p, r);
+        record(CMD_CIRCLE_AA, p.y - r - 1, p.y + r + 1, {p.x, p.y, r});
+    }
+
+    // batches are recorded one primitive at a time so each can be culled by band
+    void PicoGraphics_PenDisplayList::rectangles(const Rect *rects, size_t count) {
+        if(replaying) return PicoGraphics::rectangles(rects, count);
+        for(size_t i = 0; i < count; i++) rectangle(rects[i]);
+    }
+    void PicoGraphics_PenDisplayList::pixels(const Point *points, size_t count) {
+        if(replaying) return PicoGraphics::pixels(points, count);
+        for(size_t i = 0; i < count; i++) pixel(points[i]);
+    }
+    void PicoGraphics_PenDisplayList::pixel_spans(const Span *spans, size_t count) {
+        if(replaying) return PicoGraphics::pixel_spans(spans, count);
+        for(size_t i = 0; i < count; i++) pixel_span(spans[i].p, spans[i].l);
+    }
+    void PicoGraphics_PenDisplayList::vertical_spans(const Span *spans, size_t count) {
+        if(replaying) return PicoGraphics::vertical_spans(spans, count);
+        for(size_t i = 0; i < count; i++) rectangle(Rect(spans[i].p.x, spans[i].p.y, 1, spans[i].l));
+    }
+
+    void PicoGraphics_PenDisplayList::blit(const Bitmap &bitmap, const Rect &src, const Point &dest, int32_t scale) {
+        if(replaying) return PicoGraphics::blit(bitmap, src, dest, scale);
+        if(scale < 1) return;
+        if(record(CMD_BLIT, dest.y, dest.y + src.h * scale - 1, {}, blits.size())) {
+            blits.push_back({bitmap, src, dest, scale});
+        }
+    }
+
+    void PicoGraphics_PenDisplayList::frame_convert(PenType type, conversion_callback_func callback) {
+        if(type != PEN_RGB565) return;
+
+        RGB565 *bands[2] = {(RGB565 *)frame_buffer, (RGB565 *)frame_buffer + bounds.w * band_height};
+        int buf_idx = 0;
+
+        Rect saved_clip = clip;
+        RGB565 saved_color = color;
+        uint8_t saved_alpha = blend_alpha;
+        BlendMode saved_mode = blend_mode;
+        replaying = true;
+
+        for(band_y = 0; band_y < bounds.h; band_y += band_height) {
+            Rect band(0, band_y, bounds.w, std::min<int32_t>(band_height, bounds.h - band_y));
+            Rect user_clip = bounds;
+
+            frame_buffer = bands[buf_idx];
+            clip = band;
+            blend_alpha = 255;
+            blend_mode = BLEND_NORMAL;
+
+            {
+                PERF_SCOPE(PERF_CONVERT);
+                for(auto &c : commands) {
+                    if(c.type == CMD_SET_CLIP) {
+                        user_clip = Rect(c.a[0], c.a[1], c.a[2], c.a[3]);
+                        clip = user_clip.intersection(band);
+                        continue;
+                    }
+                    if(c.type == CMD_SET_BLEND) {
+                        blend_alpha = c.a[0];
+                        blend_mode = BlendMode(c.a[1]);
+                        continue;
+                    }
+                    if(c.y1 < band.y || c.y0 >= band.y + band.h) continue;
+
+                    color = c.color;
+                    switch(c.type) {
+                        case CMD_CLEAR:
+                            clear();
+                            break;
+                        case CMD_PIXEL:
+                            pixel(Point(c.a[0], c.a[1]));
+                            break;
+                        case CMD_PIXEL_SPAN:
+                            pixel_span(Point(c.a[0], c.a[1]), c.a[2]);
+                            break;
+                        case CMD_RECTANGLE:
+                            rectangle(Rect(c.a[0], c.a[1], c.a[2], c.a[3]));
+                            break;
+                        case CMD_CIRCLE:
+                            circle(Point(c.a[0], c.a[1]), c.a[2]);
+                            break;
+                        case CMD_TEXT:
+                            text(strings.substr(c.pool, c.a[0]), Point(c.a[1], c.a[2]), c.a[3], c.a[4], 0.0f, c.a[5]);
+                            break;
+                        case CMD_POLYGON: {
+                            // the contours are only ever grown, so replay doesn't allocate once
+                            // they are big enough
+                            size_t const count = c.a[0];
+                            if(replay_contours.size() < count) replay_contours.resize(count);
+                            auto p = points.begin() + c.pool;
+                            for(size_t i = 0; i < count; i++) {
+                                int32_t const size = p->x;
+                                replay_contours[i].assign(p + 1, p + 1 + size);
+                                p += 1 + size;
+                            }
+                            fill_polygon(replay_contours.data(), count, FillRule(c.a[1]));
+                            break;
+                        }
+                        case CMD_TRIANGLE:
+                            triangle(Point(c.a[0], c.a[1]), Point(c.a[2], c.a[3]), Point(c.a[4], c.a[5]));
+                            break;
+                        case CMD_LINE:
+                            line(Point(c.a[0], c.a[1]), Point(c.a[2], c.a[3]));
+                            break;
+                        case CMD_LINE_AA:
+                            line_aa(Point(c.a[0], c.a[1]), Point(c.a[2], c.a[3]));
+                            break;
+                        case CMD_CIRCLE_AA:
+                            circle_outline_aa(Point(c.a[0], c.a[1]), c.a[2]);
+                            break;
+                        case CMD_BLIT: {
+                            auto &b = blits[c.pool];
+                            blit(b.bitmap, b.src, b.dest, b.scale);
+                            break;
+                        }
+                        default:
+                            break;
+                    }
+                }
+            }
+
+            // Transfer a finished band and draw the next one into the other buffer
+            callback(bands[buf_idx], band.w * band.h * sizeof(RGB565));
+            buf_idx ^= 1;
+        }
+
+        replaying = false;
+        band_y = 0;
+        frame_buffer = bands[0];
+        clip = saved_clip;
+        color = saved_color;
+        blend_alpha = saved_alpha;
+        blend_mode = saved_mode;
+
+        // Callback with zero length to ensure previous buffer is fully written
+        callback(bands[buf_idx], 0);
+    }
@@ -29,6 +29,7 @@
         used[i] = true;
         palette[i] = {r, g, b};
         cache_built = false;
+        palette_rgb565_built = false;
         return i;
     }
     int PicoGraphics_PenP4::create_pen(uint8_t r, uint8_t g, uint8_t b) {
@@ -38,6 +39,7 @@
                 palette[i] = {r, g, b};
                 used[i] = true;
                 cache_built = false;
+                palette_rgb565_built = false;
                 return i;
             }
         }
@@ -47,6 +49,7 @@
         palette[i] = {0, 0, 0};
         used[i] = false;
         cache_built = false;
+        palette_rgb565_built = false;
         return i;
     }
     void PicoGraphics_PenP4::set_pixel(const Point &p) {
@@ -129,25 +132,51 @@
     }
     void PicoGraphics_PenP4::frame_convert(PenType type, conversion_callback_func callback) {
         if(type == PEN_RGB565) {
-            // Cache the RGB888 palette as RGB565
-            RGB565 cache[palette_size];
-            for(auto i = 0u; i < palette_size; i++) {
-                cache[i] = palette[i].to_rgb565();
+            // Cache the RGB888 palette as RGB565, and as pairs of pixels for whole bytes
+            if(!palette_rgb565_built) {
+                for(auto i = 0u; i < palette_size; i++) {
+                    palette_rgb565[i] = palette[i].to_rgb565();
+                }
+                for(auto i = 0u; i < 256; i++) {
+                    palette_rgb565_pairs[i] = palette_rgb565[i >> 4] | (palette_rgb565[i & 0xf] << 16);
+                }
+                palette_rgb565_built = true;
             }
 
-            // Treat our void* frame_buffer as uint8_t
-            uint8_t *src = (uint8_t *)frame_buffer;
-            uint8_t o = 4;
+            frame_convert_rgb565(callback);
+        }
+    }
+    void PicoGraphics_PenP4::convert_rgb565(uint32_t offset, uint32_t count, RGB565 *dst) {
+        // Treat our void* frame_buffer as uint8_t, the first of each pair of pixels is in the high nibble
+        uint8_t *src = (uint8_t *)frame_buffer + offset / 2;
+
+        // handle the first pixel if not byte aligned
+        if((offset & 0b1) && count) {*dst++ = palette_rgb565[*src++ & 0xf]; count--;}
+
+        // with the destination word aligned, convert eight pixels per word read
+        if(((uintptr_t)dst & 0b11) == 0) {
+            // pairs of pixels a byte at a time until the source is word aligned
+            while(count > 1 && ((uintptr_t)src & 0b11)) {
+                *(uint32_t *)dst = palette_rgb565_pairs[*src++];
+                dst += 2;
+                count -= 2;
+            }
 
-            frame_convert_rgb565(callback, [&]() {
-                uint8_t c = *src;
-                uint8_t b = (c >> o) & 0xf; // bit value shifted to position
-                
-                // Increment to next 4-bit entry 
-                o ^= 4;
-                if (o != 0) ++src;
+            uint32_t words = count / 8;
+            convert_lut8_words((uint32_t *)src, words, (uint32_t *)dst, palette_rgb565_pairs);
+            src += words * 4;
+            dst += words * 8;
+            count -= words * 8;
+        }
 
-                return cache[b];
-            });
+        // convert remaining pairs of pixels a byte at a time
+        while(count > 1) {
+            uint8_t c = *src++;
+            *dst++ = palette_rgb565[c >> 4];
+            *dst++ = palette_rgb565[c & 0xf];
+            count -= 2;
         }
+
+        // handle the last pixel if not byte aligned
+        if(count) {*dst = palette_rgb565[*src >> 4];}
     }
\ No newline at end of file
@@ -24,6 +24,7 @@
         used[i] = true;
         palette[i] = {r, g, b};
         cache_built = false;
+        palette_rgb565_built = false;
         return i;
     }
     int PicoGraphics_PenP8::create_pen(uint8_t r, uint8_t g, uint8_t b) {
@@ -33,6 +34,7 @@
                 palette[i] = {r, g, b};
                 used[i] = true;
                 cache_built = false;
+                palette_rgb565_built = false;
                 return i;
             }
         }
@@ -42,6 +44,7 @@
         palette[i] = {0, 0, 0};
         used[i] = false;
         cache_built = false;
+        palette_rgb565_built = false;
         return i;
     }
     void PicoGraphics_PenP8::set_pixel(const Point &p) {
@@ -100,16 +103,17 @@
     void PicoGraphics_PenP8::frame_convert(PenType type, conversion_callback_func callback) {
         if(type == PEN_RGB565) {
             // Cache the RGB888 palette as RGB565
-            RGB565 cache[palette_size];
-            for(auto i = 0u; i < palette_size; i++) {
-                cache[i] = palette[i].to_rgb565();
+            if(!palette_rgb565_built) {
+                for(auto i = 0u; i < palette_size; i++) {
+                    palette_rgb565[i] = palette[i].to_rgb565();
+                }
+                palette_rgb565_built = true;
             }
 
-            // Treat our void* frame_buffer as uint8_t
-            uint8_t *src = (uint8_t *)frame_buffer;
-
-            frame_convert_rgb565(callback, [&]() {
-                return cache[*src++];
-            });
+            frame_convert_rgb565(callback);
         }
     }
+    void PicoGraphics_PenP8::convert_rgb565(uint32_t offset, uint32_t count, RGB565 *dst) {
+        // Treat our void* frame_buffer as uint8_t
+        convert_lut8_rgb565((uint8_t *)frame_buffer + offset, count, dst, palette_rgb565);
+    }
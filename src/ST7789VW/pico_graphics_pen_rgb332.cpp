@@ -79,33 +79,10 @@
     }
     void PicoGraphics_PenRGB332::frame_convert(PenType type, conversion_callback_func callback) {
         if(type == PEN_RGB565) {
-
-            // Treat our void* frame_buffer as uint8_t
-            uint8_t *src = (uint8_t *)frame_buffer;
-
-            frame_convert_rgb565(callback, [&]() {
-                return rgb332_to_rgb565_lut[*src++];
-            });
+            frame_convert_rgb565(callback);
         }
     }
-    void PicoGraphics_PenRGB332::sprite(void* data, const Point &sprite, const Point &dest, const int scale, const int transparent) {
-        //int sprite_x = (sprite & 0x0f) << 3;
-        //int sprite_y = (sprite & 0xf0) >> 1;
-        Point s {
-            sprite.x << 3,
-            sprite.y << 3
-        };
-        RGB332 *ptr = (RGB332 *)data;
-        Point o = {0, 0};
-        for(o.y = 0; o.y < 8 * scale; o.y++) {
-            Point so = {
-                0,
-                o.y / scale
-            };
-            for(o.x = 0; o.x < 8 * scale; o.x++) {
-                so.x = o.x / scale;
-                color = ptr[(s.y + so.y) * 128 + (s.x + so.x)];
-                if(color != transparent) pixel(dest + o);
-            }
-        }
+    void PicoGraphics_PenRGB332::convert_rgb565(uint32_t offset, uint32_t count, RGB565 *dst) {
+        // Treat our void* frame_buffer as uint8_t
+        convert_lut8_rgb565((uint8_t *)frame_buffer + offset, count, dst, rgb332_to_rgb565_lut);
     }
\ No newline at end of file
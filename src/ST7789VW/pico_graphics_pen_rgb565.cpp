@@ -1,4 +1,5 @@
 #include "pico_graphics.hpp"
+#include <string.h>
 
     PicoGraphics_PenRGB565::PicoGraphics_PenRGB565(uint16_t width, uint16_t height, void *frame_buffer)
     : PicoGraphics(width, height, frame_buffer) {
@@ -19,14 +20,174 @@
     }
     void PicoGraphics_PenRGB565::set_pixel(const Point &p) {
         uint16_t *buf = (uint16_t *)frame_buffer;
+        if(blending()) return blend_span(&buf[p.y * bounds.w + p.x], 1, blend_alpha);
         buf[p.y * bounds.w + p.x] = color;
     }
     void PicoGraphics_PenRGB565::set_pixel_span(const Point &p, uint l) {
         // pointer to byte in framebuffer that contains this pixel
         uint16_t *buf = (uint16_t *)frame_buffer;
         buf = &buf[p.y * bounds.w + p.x];
+        if(blending()) return blend_span(buf, l, blend_alpha);
 
         while(l--) {
             *buf++ = color;
         }
+    }
+    void PicoGraphics_PenRGB565::set_pixel_alpha(const Point &p, uint8_t alpha) {
+        uint16_t *buf = (uint16_t *)frame_buffer;
+        blend_span(&buf[p.y * bounds.w + p.x], 1, (alpha * blend_alpha + 255) >> 8);
+    }
+    void PicoGraphics_PenRGB565::set_pixels(const Point *points, size_t count) {
+        uint16_t *buf = (uint16_t *)frame_buffer;
+        if(blending()) {
+            for(size_t i = 0; i < count; i++) blend_span(&buf[points[i].y * bounds.w + points[i].x], 1, blend_alpha);
+            return;
+        }
+        for(size_t i = 0; i < count; i++) {
+            buf[points[i].y * bounds.w + points[i].x] = color;
+        }
+    }
+    void PicoGraphics_PenRGB565::set_pixel_spans(const Span *spans, size_t count) {
+        uint16_t *buf = (uint16_t *)frame_buffer;
+        for(size_t i = 0; i < count; i++) {
+            uint16_t *p = &buf[spans[i].p.y * bounds.w + spans[i].p.x];
+            if(blending()) {
+                blend_span(p, spans[i].l, blend_alpha);
+                continue;
+            }
+            for(int32_t l = spans[i].l; l > 0; l--) {
+                *p++ = color;
+            }
+        }
+    }
+    void PicoGraphics_PenRGB565::set_vertical_spans(const Span *spans, size_t count) {
+        uint16_t *buf = (uint16_t *)frame_buffer;
+        uint32_t const stride = bounds.w;
+        bool const blend = blending();
+        for(size_t i = 0; i < count; i++) {
+            uint16_t *p = &buf[spans[i].p.y * stride + spans[i].p.x];
+            for(int32_t l = spans[i].l; l > 0; l--) {
+                if(blend) {
+                    blend_span(p, 1, blend_alpha);
+                } else {
+                    *p = color;
+                }
+                p += stride;
+            }
+        }
+    }
+
+    // Pixels are blended in pairs, a word at a time. A word of two screen native pixels swaps back
+    // to RGB565 with the first pixel in the low half:
+    //
+    //   rrrrrggggggbbbbb rrrrrggggggbbbbb
+    //
+    // and is split into channel groups that leave room above each channel for a product.
+    static constexpr uint32_t GROUP_A = 0x07e0f81f;  // 00000gggggg00000 rrrrr000000bbbbb
+    static constexpr uint32_t GROUP_B = 0x07c0f83f;  // the rest, shifted down 5
+    static constexpr uint32_t CHANNEL_5 = 0x001f001f;
+    static constexpr uint32_t CHANNEL_6 = 0x003f003f;
+
+    // swapping the bytes of each half also swaps them back
+    static inline uint32_t swap_pair(uint32_t w) {
+        return ((w & 0x00ff00ff) << 8) | ((w >> 8) & 0x00ff00ff);
+    }
+
+    // Clamp channels that carried into the bit above them, given those carry bits for the 5 and 6
+    // bit channels of a group
+    static inline uint32_t saturate(uint32_t sum, uint32_t carry_5, uint32_t carry_6, uint32_t group) {
+        uint32_t c5 = sum & carry_5;
+        uint32_t c6 = sum & carry_6;
+        return (sum | (c5 - (c5 >> 5)) | (c6 - (c6 >> 6))) & group;
+    }
+
+    // Apply op to every word of buf, with the odd pixels at either end done alone in the low half
+    template<typename Op>
+    static void blend_pairs(RGB565 *buf, uint l, Op op) {
+        if(l && (uintptr_t(buf) & 2)) {
+            *buf = op(*buf);
+            buf++;
+            l--;
+        }
+        uint32_t *words = (uint32_t *)buf;
+        for(; l >= 2; l -= 2) {
+            *words = op(*words);
+            words++;
+        }
+        if(l) {
+            buf = (RGB565 *)words;
+            *buf = op(*buf);
+        }
+    }
+
+    void PicoGraphics_PenRGB565::blend_span(RGB565 *buf, uint l, uint8_t alpha) {
+        uint32_t const c = __builtin_bswap16(color);
+        uint32_t const s = c | c << 16;
+
+        switch(blend_mode) {
+            case BLEND_NORMAL: {
+                uint32_t const a = (alpha + 4) >> 3;  // 0 - 32
+                if(a == 0) return;
+                if(a == 32) {
+                    while(l--) *buf++ = color;
+                    return;
+                }
+                if(l == 1) {
+                    // a lone pixel spread out to 00000gggggg00000rrrrr000000bbbbb mixes in one multiply
+                    uint32_t d = __builtin_bswap16(*buf);
+                    d = (d | d << 16) & GROUP_A;
+                    uint32_t mixed = (((s & GROUP_A) * a + d * (32 - a)) >> 5) & GROUP_A;
+                    *buf = __builtin_bswap16(uint16_t(mixed | mixed >> 16));
+                    return;
+                }
+                uint32_t const sa = (s & GROUP_A) * a;
+                uint32_t const sb = ((s >> 5) & GROUP_B) * a;
+                uint32_t const inv = 32 - a;
+                blend_pairs(buf, l, [=](uint32_t w) {
+                    uint32_t d = swap_pair(w);
+                    uint32_t ga = (((d & GROUP_A) * inv + sa) >> 5) & GROUP_A;
+                    uint32_t gb = ((((d >> 5) & GROUP_B) * inv + sb) >> 5) & GROUP_B;
+                    return swap_pair(ga | gb << 5);
+                });
+                break;
+            }
+            case BLEND_ADD: {
+                uint32_t const a = (alpha + 4) >> 3;
+                if(a == 0) return;
+                uint32_t const ta = (((s & GROUP_A) * a) >> 5) & GROUP_A;
+                uint32_t const tb = ((((s >> 5) & GROUP_B) * a) >> 5) & GROUP_B;
+                blend_pairs(buf, l, [=](uint32_t w) {
+                    uint32_t d = swap_pair(w);
+                    uint32_t ga = saturate((d & GROUP_A) + ta, 0x00010020, 0x08000000, GROUP_A);
+                    uint32_t gb = saturate(((d >> 5) & GROUP_B) + tb, 0x08010000, 0x00000040, GROUP_B);
+                    return swap_pair(ga | gb << 5);
+                });
+                break;
+            }
+            case BLEND_MULTIPLY: {
+                // per channel factors from 0 to 256, where 256 leaves the channel as it is
+                uint32_t const a = alpha + (alpha >> 7);  // 0 - 256
+                if(a == 0) return;
+                uint32_t const fr = ((c >> 11) * a + 31 * (256 - a)) / 31;
+                uint32_t const fg = (((c >> 5) & 0x3f) * a + 63 * (256 - a)) / 63;
+                uint32_t const fb = ((c & 0x1f) * a + 31 * (256 - a)) / 31;
+                blend_pairs(buf, l, [=](uint32_t w) {
+                    uint32_t d = swap_pair(w);
+                    uint32_t r = ((((d >> 11) & CHANNEL_5) * fr) >> 8) & CHANNEL_5;
+                    uint32_t g = ((((d >> 5) & CHANNEL_6) * fg) >> 8) & CHANNEL_6;
+                    uint32_t b = (((d & CHANNEL_5) * fb) >> 8) & CHANNEL_5;
+                    return swap_pair(r << 11 | g << 5 | b);
+                });
+                break;
+            }
+        }
+    }
+    void PicoGraphics_PenRGB565::frame_convert(PenType type, conversion_callback_func callback) {
+        if(type == PEN_RGB565) {
+            frame_convert_rgb565(callback);
+        }
+    }
+    void PicoGraphics_PenRGB565::convert_rgb565(uint32_t offset, uint32_t count, RGB565 *dst) {
+        // already screen native
+        memcpy(dst, (RGB565 *)frame_buffer + offset, count * sizeof(RGB565));
     }
\ No newline at end of file
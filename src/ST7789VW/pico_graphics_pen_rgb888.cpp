@@ -29,4 +29,32 @@
         while(l--) {
             *buf++ = color;
         }
+    }
+    void PicoGraphics_PenRGB888::set_pixel_alpha(const Point &p, uint8_t alpha) {
+        uint32_t *buf = (uint32_t *)frame_buffer;
+        buf[p.y * bounds.w + p.x] = blend(buf[p.y * bounds.w + p.x], color, alpha);
+    }
+    RGB888 PicoGraphics_PenRGB888::blend(RGB888 dst, RGB888 src, uint8_t alpha) {
+        // red and blue mix together in one multiply, green in another
+        uint32_t a = alpha + (alpha >> 7);  // 0 - 256
+        uint32_t rb = (((src & 0xff00ff) * a + (dst & 0xff00ff) * (256 - a)) >> 8) & 0xff00ff;
+        uint32_t g = (((src & 0x00ff00) * a + (dst & 0x00ff00) * (256 - a)) >> 8) & 0x00ff00;
+        return rb | g;
+    }
+    void PicoGraphics_PenRGB888::frame_convert(PenType type, conversion_callback_func callback) {
+        if(type == PEN_RGB565) {
+            frame_convert_rgb565(callback);
+        }
+    }
+    void PicoGraphics_PenRGB888::convert_rgb565(uint32_t offset, uint32_t count, RGB565 *dst) {
+        uint32_t *src = (uint32_t *)frame_buffer + offset;
+
+        while(count--) {
+            // same truncation as RGB::to_rgb565()
+            uint32_t c = *src++;
+            uint16_t p = ((c >> 8) & 0b1111100000000000) |
+                         ((c >> 5) & 0b0000011111100000) |
+                         ((c >> 3) & 0b0000000000011111);
+            *dst++ = __builtin_bswap16(p);
+        }
     }
\ No newline at end of file
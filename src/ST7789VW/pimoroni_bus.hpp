@@ -3,6 +3,7 @@
 #include "pimoroni_common.hpp"
 #include "hardware/gpio.h"
 #include "hardware/spi.h"
+#include "hardware/pio.h"
 
 struct SPIPins {
     spi_inst_t * spi;
@@ -12,4 +13,8 @@ struct SPIPins {
     uint miso;
     uint dc;
     uint bl;
+    uint te = PIN_UNUSED;  // tearing effect output of the panel, for ST7789::set_tear_sync()
+    // Clock the display from a state machine on this PIO instead of the SPI block, which then
+    // drives DC and CS as well. CS has to be the pin after DC, otherwise the SPI block is used.
+    PIO pio = nullptr;
 };
\ No newline at end of file
@@ -3,10 +3,22 @@
 #include <cstdlib>
 #include <cmath>
 #include "hal_impl.h"
+#include "../perf/perf_counters.hpp"
 
 uint8_t madctl;
-uint16_t caset[2] = {0, 0};
-uint16_t raset[2] = {0, 0};
+
+// ST7789 instances indexed by the DMA channel they own, for the shared DMA IRQ handler
+static ST7789 * dma_owners[NUM_DMA_CHANNELS];
+
+// and by their TE pin, for the GPIO callback
+static ST7789 * te_owners[NUM_BANK0_GPIOS];
+
+// FRCTRL2 refresh rates in Hz for RTNA 0x00 - 0x1f, with the default porch settings
+static const uint8_t frame_rates[32] = {
+        119, 111, 105, 99, 94, 90, 86, 82, 78, 75, 72, 69, 67, 64, 62, 60,
+        58, 57, 55, 53, 52, 50, 49, 48, 46, 45, 44, 43, 42, 41, 40, 39
+};
+static const uint8_t FRCTRL2_DEFAULT = 0x0f;  // 60Hz
 
 enum MADCTL : uint8_t {
     ROW_ORDER = 0b10000000,
@@ -17,13 +29,51 @@ enum MADCTL : uint8_t {
     HORIZ_ORDER = 0b00000100
 };
 
+// Clocked serial transmitter for the PIO bus, two instructions per bit with SCK on the side-set pin.
+// Every transfer is queued as a command byte and a 24 bit big endian count of the data bits that
+// follow, one byte per TX FIFO entry. DC and CS are driven from SET so that commands and pixel data
+// can be queued back to back without the CPU touching the pins.
+//   out pins: MOSI    side-set: SCK    set pins: DC (bit 0), CS (bit 1)
+static const uint PIO_WRAP_TARGET = 0;
+static const uint PIO_WRAP = 19;
+static uint16_t pio_instructions[PIO_WRAP + 1];
+
+static pio_program_t const * pio_program() {
+    static pio_program_t program = {pio_instructions, PIO_WRAP + 1, -1};
+    if (pio_instructions[0]) return &program;
+
+    auto side = [](uint sck) { return pio_encode_sideset(1, sck); };
+    uint16_t * p = pio_instructions;
+    *p++ = pio_encode_pull(false, true) | side(0);             // 0: command byte, CS still high
+    *p++ = pio_encode_set(pio_pins, 0b00) | side(0);           // 1: CS low, DC low
+    *p++ = pio_encode_set(pio_x, 7) | side(0);                 // 2:
+    *p++ = pio_encode_out(pio_pins, 1) | side(0);              // 3: command bits
+    *p++ = pio_encode_jmp_x_dec(3) | side(1);                  // 4:
+    *p++ = pio_encode_mov(pio_isr, pio_null) | side(0);        // 5: assemble the bit count in ISR
+    for (int i = 0; i < 3; i++) {
+        *p++ = pio_encode_out(pio_x, 8) | side(0);             // 6, 8, 10:
+        *p++ = pio_encode_in(pio_x, 8) | side(0);              // 7, 9, 11:
+    }
+    *p++ = pio_encode_mov(pio_y, pio_isr) | side(0);           // 12:
+    *p++ = pio_encode_jmp_not_y(18) | side(0);                 // 13: no data
+    *p++ = pio_encode_set(pio_pins, 0b01) | side(0);           // 14: DC high
+    *p++ = pio_encode_jmp_y_dec(16) | side(0);                 // 15: loop runs y times
+    *p++ = pio_encode_out(pio_pins, 1) | side(0);              // 16: data bits
+    *p++ = pio_encode_jmp_y_dec(16) | side(1);                 // 17:
+    *p++ = pio_encode_nop() | side(0) | pio_encode_delay(1);   // 18: CS hold after the last edge
+    *p++ = pio_encode_set(pio_pins, 0b10) | side(0);           // 19: CS high
+    return &program;
+}
+
 
 void ST7789::common_init() {
-    gpio_set_function(dc, GPIO_FUNC_SIO);
-    gpio_set_dir(dc, GPIO_OUT);
+    if (!pio) {
+        gpio_set_function(dc, GPIO_FUNC_SIO);
+        gpio_set_dir(dc, GPIO_OUT);
 
-    gpio_set_function(cs, GPIO_FUNC_SIO);
-    gpio_set_dir(cs, GPIO_OUT);
+        gpio_set_function(cs, GPIO_FUNC_SIO);
+        gpio_set_dir(cs, GPIO_OUT);
+    }
 
     gpio_init(LCD_RST_PIN);
     gpio_set_dir(LCD_RST_PIN, GPIO_OUT);
@@ -58,7 +108,7 @@ void ST7789::common_init() {
     command(reg::VRHS, 1, "\x12");
     command(reg::VDVS, 1, "\x20");
     command(reg::PWCTRL1, 2, "\xa4\xa1");
-    command(reg::FRCTRL2, 1, "\x0f");
+    command(reg::FRCTRL2, 1, (char const *) &FRCTRL2_DEFAULT);
 
     if (width == 320 && height == 240) {
         command(reg::GCTRL, 1, "\x35");
@@ -77,11 +127,64 @@ void ST7789::common_init() {
     configure_display(rotation);
 }
 
+void ST7789::pio_init() {
+    pio_program_t const * program = pio_program();
+    pio_offset = pio_add_program(pio, program);
+    pio_sm = pio_claim_unused_sm(pio, true);
+
+    pio_sm_config config = pio_get_default_sm_config();
+    sm_config_set_wrap(&config, pio_offset + PIO_WRAP_TARGET, pio_offset + PIO_WRAP);
+    sm_config_set_sideset(&config, 1, false, false);
+    sm_config_set_sideset_pins(&config, wr_sck);
+    sm_config_set_out_pins(&config, d0, 1);
+    sm_config_set_set_pins(&config, dc, 2);
+
+    // MSB first, refilled a byte at a time so commands and data can be any length
+    sm_config_set_out_shift(&config, false, true, 8);
+    sm_config_set_in_shift(&config, false, false, 32);
+    sm_config_set_fifo_join(&config, PIO_FIFO_JOIN_TX);
+
+    // a bit every two cycles, slowed down to the panel limit if clk_sys is fast enough to exceed it
+    float const div = std::max(float(clock_get_hz(clk_sys)) / (2.0f * SPI_BAUD), 1.0f);
+    sm_config_set_clkdiv(&config, div);
+    bus_hz = uint32_t(clock_get_hz(clk_sys) / (2.0f * div));
+
+    for (uint pin : {wr_sck, d0, dc, cs}) {
+        pio_gpio_init(pio, pin);
+        pio_sm_set_consecutive_pindirs(pio, pio_sm, pin, 1, true);
+    }
+    pio_sm_set_pins_with_mask(pio, pio_sm, 1u << cs, (1u << wr_sck) | (1u << dc) | (1u << cs));
+
+    pio_sm_init(pio, pio_sm, pio_offset, &config);
+    pio_sm_set_enabled(pio, pio_sm, true);
+}
+
+void ST7789::pio_wait_idle() {
+    // the state machine stalls on an empty FIFO only once everything queued has been shifted out
+    uint32_t const stall = 1u << (PIO_FDEBUG_TXSTALL_LSB + pio_sm);
+    pio->fdebug = stall;
+    while (!(pio->fdebug & stall));
+}
+
 void ST7789::cleanup() {
     if (dma_channel_is_claimed(st_dma)) {
+        dma_channel_set_irq0_enabled(st_dma, false);
+        dma_owners[st_dma] = nullptr;
         dma_channel_abort(st_dma);
         dma_channel_unclaim(st_dma);
     }
+    if (tear_sync) {
+        gpio_set_irq_enabled(te, GPIO_IRQ_EDGE_RISE, false);
+        te_owners[te] = nullptr;
+        tear_sync = false;
+    }
+    if (pio) {
+        pio_wait_idle();
+        pio_sm_set_enabled(pio, pio_sm, false);
+        pio_remove_program(pio, pio_program(), pio_offset);
+        pio_sm_unclaim(pio, pio_sm);
+        pio = nullptr;
+    }
 }
 
 void ST7789::configure_display(Rotation rotate) {
@@ -93,73 +196,366 @@ void ST7789::configure_display(Rotation rotate) {
 
     // Pico Display 2.0
     if (width == 320 && height == 240) {
-        caset[0] = 0;
-        caset[1] = 319;
-        raset[0] = 0;
-        raset[1] = 239;
         madctl = rotate180 ? MADCTL::ROW_ORDER : MADCTL::COL_ORDER;
         madctl |= MADCTL::SWAP_XY | MADCTL::SCAN_ORDER;
     }
 
     // Pico Display 2.0 at 90 degree rotation
     if (width == 240 && height == 320) {
-        caset[0] = 0;
-        caset[1] = 239;
-        raset[0] = 0;
-        raset[1] = 319;
         madctl = rotate180 ? (MADCTL::COL_ORDER | MADCTL::ROW_ORDER) : 0;
     }
 
-    // Byte swap the 16bit rows/cols values
-    caset[0] = __builtin_bswap16(caset[0]);
-    caset[1] = __builtin_bswap16(caset[1]);
-    raset[0] = __builtin_bswap16(raset[0]);
-    raset[1] = __builtin_bswap16(raset[1]);
-
-    command(reg::CASET, 4, (char *) caset);
-    command(reg::RASET, 4, (char *) raset);
+    set_window(Rect(0, 0, width, height));
     command(reg::MADCTL, 1, (char *) &madctl);
 }
 
+void ST7789::set_window(const Rect & r) {
+    // start and end addresses are inclusive and sent big endian
+    if (r.x != window.x || r.w != window.w) {
+        uint16_t caset[2] = {__builtin_bswap16(r.x), __builtin_bswap16(r.x + r.w - 1)};
+        command(reg::CASET, 4, (char *) caset);
+    }
+    if (r.y != window.y || r.h != window.h) {
+        uint16_t raset[2] = {__builtin_bswap16(r.y), __builtin_bswap16(r.y + r.h - 1)};
+        command(reg::RASET, 4, (char *) raset);
+    }
+    window = r;
+}
+
 void ST7789::write_blocking_dma(uint8_t const * src, size_t len) const {
-    while (dma_channel_is_busy(st_dma));
+    PERF_BYTES(len);
+    {
+        PERF_SCOPE(PERF_DMA_WAIT);
+        while (dma_channel_is_busy(st_dma));
+    }
     dma_channel_set_trans_count(st_dma, len, false);
     dma_channel_set_read_addr(st_dma, src, true);
 }
 
+void ST7789::wait_for_dma() const {
+    PERF_SCOPE(PERF_DMA_WAIT);
+    dma_channel_wait_for_finish_blocking(st_dma);
+}
+
 void ST7789::command(uint8_t command, size_t len, char const * data) {
+    wait_for_update();
+    begin_command(command, data ? len : 0);
+    if (data) {
+        write_data((uint8_t const *) data, len);
+    }
+    end_command();
+}
+
+void ST7789::begin_command(uint8_t command, size_t len) {
+    if (pio) {
+        // DC and CS follow from the bit count, which has to fit 24 bits (2MB of data)
+        uint32_t const bits = len * 8;
+        uint8_t const header[4] = {command, uint8_t(bits >> 16), uint8_t(bits >> 8), uint8_t(bits)};
+        write_data(header, sizeof(header));
+        return;
+    }
+
     gpio_put(dc, 0); // command mode
     gpio_put(cs, 0);
     spi_write_blocking(spi, &command, 1);
-    if (data) {
-        gpio_put(dc, 1); // data mode
-        spi_write_blocking(spi, (uint8_t const *) data, len);
+    gpio_put(dc, 1); // data mode
+}
+
+void ST7789::write_data(uint8_t const * src, size_t len) {
+    PERF_BYTES(len);
+    if (!pio) {
+        spi_write_blocking(spi, src, len);
+        return;
     }
+    while (len--) {
+        pio_sm_put_blocking(pio, pio_sm, uint32_t(*src++) << 24);
+    }
+}
+
+void ST7789::end_command() {
+    // the state machine raises CS by itself once the data it was told about has gone out
+    if (pio) return;
+
+    while (spi_is_busy(spi));
     gpio_put(cs, 1);
 }
 
 void ST7789::update(PicoGraphics * graphics) {
+    PERF_SCOPE(PERF_UPDATE);
+    PERF_FRAME();
+
+    if (scale > 1) {
+        // a framebuffer that can't be sent keeps its damage
+        if (update_scaled(graphics)) graphics->clear_damage();
+        return;
+    }
+
+    // only RGB565 framebuffers can be sent a region at a time, and only blocking, so async updates
+    // send the whole frame and swap in the back buffer as usual
+    if (graphics->track_damage && !async_update && graphics->pen_type == PicoGraphics::PEN_RGB565) {
+        if (tear_sync) wait_for_tear();
+        graphics->get_damage([this, graphics](const Rect & region) {
+            partial_update(graphics, region);
+        });
+    } else {
+        update_frame(graphics);
+    }
+    graphics->clear_damage();
+}
+
+void ST7789::partial_update(PicoGraphics * graphics, Rect region) {
+    PERF_SCOPE(PERF_UPDATE);
+
+    if (scale > 1) {
+        update_scaled(graphics);
+        return;
+    }
+
+    if (graphics->pen_type != PicoGraphics::PEN_RGB565) {
+        update_frame(graphics);
+        return;
+    }
+
+    region = region.intersection(graphics->bounds);
+    if (region.empty()) return;
+
+    wait_for_update();
+    set_window(region);
+
+    begin_command(reg::RAMWR, region.w * region.h * sizeof(uint16_t));
+
+    auto src = (uint16_t const *) graphics->frame_buffer + region.y * graphics->bounds.w + region.x;
+    if (region.w == graphics->bounds.w) {
+        // full width rows are contiguous in the framebuffer
+        write_blocking_dma((uint8_t const *) src, region.w * region.h * sizeof(uint16_t));
+    } else {
+        for (int32_t y = 0; y < region.h; y++) {
+            write_blocking_dma((uint8_t const *) src, region.w * sizeof(uint16_t));
+            src += graphics->bounds.w;
+        }
+    }
+    wait_for_dma();
+
+    end_command();
+}
+
+void ST7789::update_frame(PicoGraphics * graphics) {
     uint8_t cmd = reg::RAMWR;
 
-    if (graphics->pen_type == PicoGraphics::PEN_RGB565) {
+    set_window(Rect(0, 0, width, height));
+
+    if (graphics->pen_type == PicoGraphics::PEN_RGB565 && async_update) {
+        // the previous frame has to be off the bus before the next RAMWR
+        wait_for_update();
+
+        dma_busy = true;
+        pending_frame = (uint8_t const *) graphics->frame_buffer;
+        if (tear_sync) {
+            te_armed_at = time_us_32();
+            te_pending = true;
+        } else {
+            start_frame();
+        }
+
+        if (back_buffer) {
+            std::swap(back_buffer, graphics->frame_buffer);
+        }
+    } else if (graphics->pen_type == PicoGraphics::PEN_RGB565) {
         // display buffer is screen native
+        if (tear_sync) wait_for_tear();
         command(cmd, width * height * sizeof(uint16_t), (char const *) graphics->frame_buffer);
     } else {
-        gpio_put(dc, 0); // command mode
-        gpio_put(cs, 0);
-        spi_write_blocking(spi, &cmd, 1);
+        wait_for_update();
+        if (tear_sync) wait_for_tear();
 
-        gpio_put(dc, 1); // data mode
+        begin_command(cmd, width * height * sizeof(uint16_t));
 
         graphics->frame_convert(PicoGraphics::PEN_RGB565, [this](void * data, size_t length) {
             if (length > 0) {
                 write_blocking_dma((uint8_t const *) data, length);
             } else {
-                dma_channel_wait_for_finish_blocking(st_dma);
+                wait_for_dma();
             }
         });
 
-        gpio_put(cs, 1);
+        end_command();
+    }
+}
+
+bool ST7789::set_scale(uint8_t scale) {
+    if ((scale != 1 && scale != 2 && scale != 4) || width % scale || height % scale) return false;
+
+    wait_for_update();
+    this->scale = scale;
+    if (scale > 1) {
+        scale_rows.resize(width);
+    } else {
+        scale_rows.clear();
+        scale_rows.shrink_to_fit();
+    }
+    return true;
+}
+
+bool ST7789::update_scaled(PicoGraphics * graphics) {
+    bool const fits = graphics->bounds.w * scale == width && graphics->bounds.h * scale == height;
+    assert(fits);
+    if (!fits) return false;
+
+    wait_for_update();
+    set_window(Rect(0, 0, width, height));
+    if (tear_sync) wait_for_tear();
+    begin_command(reg::RAMWR, width * height * sizeof(uint16_t));
+
+    // rows are widened into one buffer while the other is on the wire
+    uint32_t * rows[2] = {&scale_rows[0], &scale_rows[width / 2]};
+    int row_idx = 0;
+    uint32_t * dst = rows[0];
+    int32_t x = 0;
+
+    graphics->frame_convert(PicoGraphics::PEN_RGB565, [&](void * data, size_t length) {
+        if (length == 0) {
+            wait_for_dma();
+            return;
+        }
+
+        auto src = (uint16_t const *) data;
+        for (size_t n = length / sizeof(uint16_t); n; n--) {
+            uint32_t const pair = *src * 0x10001u;
+            *dst++ = pair;
+            if (scale == 4) *dst++ = pair;
+
+            if (++x == graphics->bounds.w) {
+                for (int i = 0; i < scale; i++) {
+                    write_blocking_dma((uint8_t const *) rows[row_idx], width * sizeof(uint16_t));
+                }
+                row_idx ^= 1;
+                dst = rows[row_idx];
+                x = 0;
+            }
+            src++;
+        }
+    });
+
+    end_command();
+    return true;
+}
+
+bool ST7789::set_tear_sync(bool enable) {
+    if (te == PIN_UNUSED) return false;
+
+    wait_for_update();
+    if (enable == tear_sync) return true;
+
+    uint8_t rtna = FRCTRL2_DEFAULT;
+    if (enable) {
+        // the fastest refresh with a frame period longer than a frame write, with a margin for the
+        // IRQ latency and gaps on the bus
+        uint64_t const write_us = uint64_t(width) * height * 16 * 1'000'000 / bus_hz;
+        rtna = sizeof(frame_rates) - 1;
+        for (uint8_t i = 0; i < sizeof(frame_rates); i++) {
+            if (1'000'000 / frame_rates[i] >= write_us + write_us / 10) {
+                rtna = i;
+                break;
+            }
+        }
+        frame_us = 1'000'000 / frame_rates[rtna];
+
+        gpio_init(te);
+        gpio_set_dir(te, GPIO_IN);
+        te_owners[te] = this;
+        gpio_set_irq_enabled_with_callback(te, GPIO_IRQ_EDGE_RISE, true, te_irq_handler);
+        command(reg::TEON, 1, "\x00");  // V-blank only
+    } else {
+        gpio_set_irq_enabled(te, GPIO_IRQ_EDGE_RISE, false);
+        te_owners[te] = nullptr;
+        command(reg::TEOFF);
+    }
+    command(reg::FRCTRL2, 1, (char const *) &rtna);
+
+    tear_sync = enable;
+    return true;
+}
+
+void ST7789::start_frame() {
+    te_pending = false;
+    begin_command(reg::RAMWR, width * height * sizeof(uint16_t));
+
+    // CS is raised again by the DMA IRQ once the transfer completes
+    dma_channel_acknowledge_irq0(st_dma);
+    dma_channel_set_irq0_enabled(st_dma, true);
+    write_blocking_dma(pending_frame, width * height * sizeof(uint16_t));
+}
+
+void ST7789::wait_for_tear() {
+    // give up after a frame and a bit, an update is better late than never
+    uint32_t const count = te_count;
+    uint32_t const start = time_us_32();
+    while (te_count == count && time_us_32() - start < frame_us + frame_us / 4) {
+        tight_loop_contents();
+    }
+}
+
+void ST7789::te_irq_handler(uint gpio, uint32_t events) {
+    ST7789 * owner = te_owners[gpio];
+    if (!owner) return;
+
+    owner->te_count++;
+    if (owner->te_pending) owner->start_frame();
+}
+
+bool ST7789::is_busy() {
+    start_overdue_frame();
+    return dma_busy;
+}
+
+void ST7789::set_async_update(bool enable, void * back_buffer) {
+    static bool irq_handler_installed = false;
+
+    wait_for_update();
+    async_update = enable;
+    this->back_buffer = enable ? back_buffer : nullptr;
+    dma_owners[st_dma] = enable ? this : nullptr;
+
+    if (enable && !irq_handler_installed) {
+        irq_add_shared_handler(DMA_IRQ_0, dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        irq_handler_installed = true;
+    }
+}
+
+void ST7789::wait_for_update() {
+    PERF_SCOPE(PERF_DMA_WAIT);
+    while (dma_busy) {
+        start_overdue_frame();
+        tight_loop_contents();
+    }
+}
+
+void ST7789::start_overdue_frame() {
+    // without a TE edge for two frames start the pending frame here instead
+    if (te_pending && time_us_32() - te_armed_at > frame_us * 2) {
+        gpio_set_irq_enabled(te, GPIO_IRQ_EDGE_RISE, false);
+        if (te_pending) start_frame();
+        gpio_set_irq_enabled(te, GPIO_IRQ_EDGE_RISE, true);
+    }
+}
+
+void ST7789::end_async_update() {
+    dma_channel_set_irq0_enabled(st_dma, false);
+
+    // the DMA finishes once the last byte is queued, end_command() waits for the FIFO to drain
+    end_command();
+
+    dma_busy = false;
+}
+
+void __isr ST7789::dma_irq_handler() {
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        ST7789 * owner = dma_owners[channel];
+        if (owner && dma_channel_get_irq0_status(channel)) {
+            dma_channel_acknowledge_irq0(channel);
+            owner->end_async_update();
+        }
     }
 }
 
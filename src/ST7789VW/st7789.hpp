@@ -2,6 +2,7 @@
 
 #include "hardware/spi.h"
 #include "hardware/dma.h"
+#include "hardware/irq.h"
 #include "hardware/gpio.h"
 #include "hardware/pio.h"
 #include "hardware/pwm.h"
@@ -11,6 +12,8 @@
 #include "pico_graphics.hpp"
 
 #include <algorithm>
+#include <cassert>
+#include <vector>
 
 enum reg {
     SWRESET = 0x01,
@@ -58,7 +61,34 @@ private:
     uint const wr_sck;    // clock
     uint const d0;        // MOSI
     uint const bl;        // backlight
+    uint const te;        // tearing effect
     int st_dma;
+    uint32_t bus_hz;      // bit rate of the bus the frames go out on
+
+    // state machine clocking the display out when a PIO is given in SPIPins, in place of spi
+    PIO pio = nullptr;
+    uint pio_sm = 0;
+    uint pio_offset = 0;
+
+    // non-blocking update state, see set_async_update()
+    bool async_update = false;
+    void * back_buffer = nullptr;
+    volatile bool dma_busy = false;
+
+    // frames started from the TE edge, see set_tear_sync()
+    bool tear_sync = false;
+    uint32_t frame_us = 0;                // refresh period picked for the bus
+    volatile uint32_t te_count = 0;       // TE edges seen
+    volatile bool te_pending = false;     // an async frame is waiting for the next edge
+    uint32_t te_armed_at = 0;
+    uint8_t const * pending_frame = nullptr;
+
+    // pixel doubling, see set_scale()
+    uint8_t scale = 1;
+    std::vector<uint32_t> scale_rows;  // two panel rows of RGB565
+
+    // current CASET/RASET window
+    Rect window;
 
 
     // The ST7789 requires 16 ns between SPI rising edges.
@@ -70,39 +100,116 @@ public:
     ST7789(uint16_t width, uint16_t height, Rotation rotation, bool round, SPIPins pins) :
             DisplayDriver(width, height, rotation),
             spi(pins.spi), round(round),
-            cs(pins.cs), dc(pins.dc), wr_sck(pins.sck), d0(pins.mosi), bl(pins.bl) {
-
-        // configure SPI interface and pins
-        uint speed = spi_init(spi, SPI_BAUD);
-        spi_get_hw(spi)->cpsr = 4;
-        hw_write_masked(&spi_get_hw(spi)->cr0, 0, SPI_SSPCR0_SCR_BITS);
-
-        gpio_set_function(wr_sck, GPIO_FUNC_SPI);
-        gpio_set_function(d0, GPIO_FUNC_SPI);
-
-        // configure DMA
+            cs(pins.cs), dc(pins.dc), wr_sck(pins.sck), d0(pins.mosi), bl(pins.bl), te(pins.te), pio(pins.pio) {
+
+        // the state machine sets DC and CS together, so without CS on the pin after DC the SPI
+        // block clocks the display instead
+        bool const pio_pins = dc < NUM_BANK0_GPIOS - 1 && cs == dc + 1;
+        assert(!pio || pio_pins);
+        if (!pio_pins) pio = nullptr;
+
+        if (pio) {
+            pio_init();
+        } else {
+            // configure SPI interface and pins
+            uint speed = spi_init(spi, SPI_BAUD);
+            spi_get_hw(spi)->cpsr = 4;
+            hw_write_masked(&spi_get_hw(spi)->cr0, 0, SPI_SSPCR0_SCR_BITS);
+
+            gpio_set_function(wr_sck, GPIO_FUNC_SPI);
+            gpio_set_function(d0, GPIO_FUNC_SPI);
+            bus_hz = spi_get_baudrate(spi);
+        }
+
+        // configure DMA, byte writes to the PIO TX FIFO are replicated across the word so the
+        // state machine finds each byte in the top bits it shifts out first
         st_dma = dma_claim_unused_channel(true);
         dma_channel_config config = dma_channel_get_default_config(st_dma);
         channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
         channel_config_set_bswap(&config, false);
-        channel_config_set_dreq(&config, spi_get_dreq(spi, true));
-        dma_channel_configure(st_dma, &config, &spi_get_hw(spi)->dr, nullptr, 0, false);
+        if (pio) {
+            channel_config_set_dreq(&config, pio_get_dreq(pio, pio_sm, true));
+            dma_channel_configure(st_dma, &config, &pio->txf[pio_sm], nullptr, 0, false);
+        } else {
+            channel_config_set_dreq(&config, spi_get_dreq(spi, true));
+            dma_channel_configure(st_dma, &config, &spi_get_hw(spi)->dr, nullptr, 0, false);
+        }
 
         common_init();
     }
 
     void cleanup() override;
 
+    // Sends the whole frame, or only the damaged regions if the graphics tracks damage. Regions are
+    // sent blocking, so with async updates on the whole frame is sent instead and the damage dropped.
     void update(PicoGraphics * graphics) override;
 
+    void partial_update(PicoGraphics * graphics, Rect region) override;
+
     void set_backlight(uint8_t brightness) override;
 
+    bool is_busy() override;
+
+    // When enabled, update() of an RGB565 framebuffer starts the DMA transfer and returns at once, with
+    // completion signalled from the DMA IRQ. If a back buffer is given the graphics framebuffer is
+    // swapped with it on every update, so the next frame is drawn while the previous one is sent.
+    // The swapped in buffer still holds the frame from two updates ago. Graphics that track damage are
+    // sent whole too, see update().
+    void set_async_update(bool enable, void * back_buffer = nullptr);
+
+    void wait_for_update();
+
+    // Draw a framebuffer of 1/scale the panel size, 2 or 4, to the whole panel. Each row is widened
+    // as it is converted and sent scale times, so no full size copy is needed. Damage tracking is
+    // ignored while scaled. Returns false if the scale is unsupported or doesn't divide the panel.
+    // Updates of a framebuffer of any other size assert, or send nothing with assertions off.
+    bool set_scale(uint8_t scale);
+
+    // Start full frame writes on the rising edge of the panel's TE output, at the start of vertical
+    // blanking, and lower the refresh rate (FRCTRL2) until the bus writes a frame faster than the
+    // panel scans it out, so the scan never overtakes the write. Async updates are started from the
+    // GPIO IRQ, which takes the GPIO callback of the calling core, and blocking ones wait for the
+    // edge. Missing edges only delay an update by a frame. Returns false without a TE pin.
+    bool set_tear_sync(bool enable);
+
 private:
     void common_init();
 
+    void pio_init();
+
+    void pio_wait_idle();
+
     void configure_display(Rotation rotate);
 
+    void set_window(const Rect & r);
+
+    void update_frame(PicoGraphics * graphics);
+
+    bool update_scaled(PicoGraphics * graphics);
+
+    void start_frame();
+
+    void wait_for_tear();
+
+    void start_overdue_frame();
+
     void write_blocking_dma(uint8_t const * src, size_t len) const;
 
+    void wait_for_dma() const;
+
     void command(uint8_t command, size_t len = 0, char const * data = nullptr);
+
+    // Send the command byte and select data mode for the len bytes that follow, from write_data()
+    // or write_blocking_dma(). end_command() releases CS once they are all on the bus.
+    void begin_command(uint8_t command, size_t len);
+
+    void write_data(uint8_t const * src, size_t len);
+
+    void end_command();
+
+    void end_async_update();
+
+    static void dma_irq_handler();
+
+    static void te_irq_handler(uint gpio, uint32_t events);
 };
@@ -6,6 +6,8 @@
 #include "hardware/i2c.h"
 
 #include "SSD1306/SSD1306.h"
+#include "perf/perf_counters.hpp"
+#include "pipeline/render_pipeline.hpp"
 #include "ST7789VW/pico_graphics.hpp"
 #include "ST7789VW/st7789.hpp"
 #include "ST7789VW/hal_impl.h"
@@ -17,7 +19,7 @@
 #include "main.hpp"
 
 
-void draw_sin(SSD1306 & disp, uint8_t offset, uint8_t y_scale) {
+void draw_sin(PicoGraphics & graphics, uint8_t offset, uint8_t y_scale) {
     float const offset_rad = 4 * M_PI * (offset / 128.0);
     float const y_offset = 31 - y_scale;  // vertically center the graph
 
@@ -28,21 +30,21 @@ void draw_sin(SSD1306 & disp, uint8_t offset, uint8_t y_scale) {
         float const xr = 4 * M_PI * (x / 128.0);
         float const dy = round(y_scale * (sin(xr - offset_rad) + 1)) + y_offset;
         auto const y = static_cast<uint8_t>(dy);
-        disp.draw_pixel(x, y);
+        graphics.pixel(Point(x, y));
     }
 
     for (uint8_t x = 0; x < 128; x++) {
         float const xr = 4 * M_PI * (x / 128.0);
         float const dy = round(y_scale * (sin(xr - TWOPI_3 - offset_rad) + 1)) + y_offset;
         auto const y = static_cast<uint8_t>(dy);
-        disp.draw_pixel(x, y);
+        graphics.pixel(Point(x, y));
     }
 
     for (uint8_t x = 0; x < 128; x++) {
         float const xr = 4 * M_PI * (x / 128.0);
         float const dy = round(y_scale * (sin(xr - FOURPI_3 - offset_rad) + 1)) + y_offset;
         auto const y = static_cast<uint8_t>(dy);
-        disp.draw_pixel(x, y);
+        graphics.pixel(Point(x, y));
     }
 }
 
@@ -65,27 +67,17 @@ void draw_fast(PicoGraphics & graphics, int offset) {
     static uint const width = 320;
     static uint const height = 240;
 
-    static uint8_t const thickness_x = 1;
     static uint8_t const thickness_y = 6;
 
-    for (uint x = 0; x < width; x++) {
-        uint const y = fast_function(x - offset);
-//        graphics.pixel(Point(x, y));
-        graphics.rectangle(Rect(x, y, thickness_x, thickness_y));
-    }
-
-    for (uint x = 0; x < width; x++) {
-        uint const y = fast_function(x - offset - 33);
-//        graphics.pixel(Point(x, y));
-        graphics.rectangle(Rect(x, y, thickness_x, thickness_y));
-    }
+    // all three waves as one batch of columns
+    static Span columns[width * 3];
 
     for (uint x = 0; x < width; x++) {
-        uint const y = fast_function(x - offset - 66);
-//        graphics.pixel(Point(x, y));
-        graphics.rectangle(Rect(x, y, thickness_x, thickness_y));
+        columns[x] = Span(Point(x, fast_function(x - offset)), thickness_y);
+        columns[width + x] = Span(Point(x, fast_function(x - offset - 33)), thickness_y);
+        columns[width * 2 + x] = Span(Point(x, fast_function(x - offset - 66)), thickness_y);
     }
-
+    graphics.vertical_spans(columns, width * 3);
 }
 
 void draw_sin(PicoGraphics & graphics, uint16_t offset, uint16_t y_scale) {
@@ -98,32 +90,29 @@ void draw_sin(PicoGraphics & graphics, uint16_t offset, uint16_t y_scale) {
     float const offset_rad = 4 * M_PI * (offset / width);
     float const y_offset = (height / 2.0f - 1) - y_scale;  // vertically center the graph
 
-    static uint8_t const thickness_x = 1;
-    static uint8_t const thickness_y = 4;
+    // one anti-aliased trace per wave, on pens that can blend
+    std::vector<Point> trace(width);
 
     for (uint16_t x = 0; x < width; x++) {
         float const xr = 4 * M_PI * (x / width);
         float const dy = round(y_scale * (sin(xr - offset_rad) + 1)) + y_offset;
-        auto const y = static_cast<uint16_t>(dy);
-//        graphics.pixel(Point(x, y));
-        graphics.rectangle(Rect(x, y, thickness_x, thickness_y));
+        trace[x] = Point(x, static_cast<uint16_t>(dy));
     }
+    graphics.polyline_aa(trace);
 
     for (uint16_t x = 0; x < width; x++) {
         float const xr = 4 * M_PI * (x / width);
         float const dy = round(y_scale * (sin(xr - TWOPI_3 - offset_rad) + 1)) + y_offset;
-        auto const y = static_cast<uint16_t>(dy);
-//        graphics.pixel(Point(x, y));
-        graphics.rectangle(Rect(x, y, thickness_x, thickness_y));
+        trace[x] = Point(x, static_cast<uint16_t>(dy));
     }
+    graphics.polyline_aa(trace);
 
     for (uint16_t x = 0; x < width; x++) {
         float const xr = 4 * M_PI * (x / width);
         float const dy = round(y_scale * (sin(xr - FOURPI_3 - offset_rad) + 1)) + y_offset;
-        auto const y = static_cast<uint16_t>(dy);
-//        graphics.pixel(Point(x, y));
-        graphics.rectangle(Rect(x, y, thickness_x, thickness_y));
+        trace[x] = Point(x, static_cast<uint16_t>(dy));
     }
+    graphics.polyline_aa(trace);
 }
 
 void measure_freqs() {
@@ -162,6 +151,11 @@ int main() {
 //    sleep_ms(3000);
 //    measure_freqs();
 
+#if PERF_COUNTERS
+    // the counters are reported over stdio
+    stdio_init_all();
+#endif
+
 
     // initialize hardware for LED
     const uint LED_PIN = PICO_DEFAULT_LED_PIN;
@@ -200,11 +194,22 @@ int main() {
 //    hw_write_masked(&spi_get_hw(spi0)->cr0, 0, SPI_SSPCR0_SCR_BITS);
 
     SSD1306 disp(128, 64, 0x3C, i2c0);
-    disp.clear();
-    disp.show();
+    // or for SPI wired modules, with spi_init(spi0, 10'000'000) above
+//    SSD1306TransportSPI oled_spi(spi0, SPI_Pins::DC);
+//    SSD1306 disp(128, 64, oled_spi);
+    PicoGraphics_Pen1BitY oled(disp.width, disp.height, nullptr);
+    oled.set_pen(0);
+    oled.clear();
+    disp.update(&oled);
+
+    // core1 sends each frame to the display while core0 draws the next one
+    RenderPipeline<PicoGraphics_Pen1BitY> pipeline(disp, oled);
+    pipeline.start();
 
     // initialize hardware for SPI IPS LCD
 //    SPIPins pins{spi0, LCD_CS_PIN, LCD_CLK_PIN, LCD_MOSI_PIN, PIN_UNUSED, LCD_DC_PIN, PIN_UNUSED};
+//    // or clocked out by PIO, with DC and CS on consecutive pins
+//    pins.pio = pio0;
 //    ST7789 st7789(320, 240, ROTATE_0, false, pins);
 //    PicoGraphics_PenRGB565 graphics(st7789.width, st7789.height, nullptr);
 //    Pen bg_pen = graphics.create_pen(0, 0, 0);
@@ -219,25 +224,33 @@ int main() {
 
 //        led_status = ~led_status;
 //        gpio_put(LED_PIN, led_status);
-//        disp.clear();
-//        disp.draw_string(0, 8 * 0, 1, "ABCDEFGHIJKLMNOPQRSTU");
-//        disp.draw_string(0, 8 * 1, 1, "VWXYZabcdefghijklmnop");
-//        disp.draw_string(0, 8 * 2, 1, "qrstuvwxyzABCDEFGHIJK");
-//        disp.draw_string(0, 8 * 3, 1, "012345678901234567890");
-//        disp.draw_string(0, 8 * 4, 1, "ABCDEFGHIJKLMNOPQRSTU");
-//        disp.draw_string(0, 8 * 5, 1, "VWXYZabcdefghijklmnop");
-//        disp.draw_string(0, 8 * 6, 1, "qrstuvwxyzABCDEFGHIJK");
-//        disp.draw_string(0, 8 * 7, 1, "012345678901234567890");
-//        disp.show();
+//        oled.set_pen(0);
+//        oled.clear();
+//        oled.set_pen(15);
+//        oled.text("ABCDEFGHIJKLMNOPQRSTU", Point(0, 8 * 0), 128, 1);
+//        oled.text("VWXYZabcdefghijklmnop", Point(0, 8 * 1), 128, 1);
+//        oled.text("qrstuvwxyzABCDEFGHIJK", Point(0, 8 * 2), 128, 1);
+//        oled.text("012345678901234567890", Point(0, 8 * 3), 128, 1);
+//        oled.text("ABCDEFGHIJKLMNOPQRSTU", Point(0, 8 * 4), 128, 1);
+//        oled.text("VWXYZabcdefghijklmnop", Point(0, 8 * 5), 128, 1);
+//        oled.text("qrstuvwxyzABCDEFGHIJK", Point(0, 8 * 6), 128, 1);
+//        oled.text("012345678901234567890", Point(0, 8 * 7), 128, 1);
+//        pipeline.present();
 //        sleep_ms(1000);
 
         for (uint16_t offset = 0; offset < 128; offset++) {
             led_status = ~led_status;
             gpio_put(LED_PIN, led_status);
 
-            disp.clear();
-            draw_sin(disp, offset, 31);
-            disp.show();
+            oled.set_pen(0);
+            oled.clear();
+            oled.set_pen(15);
+            draw_sin(oled, offset, 31);
+            pipeline.present();
+
+#if PERF_COUNTERS
+            perf_report_every(1000);
+#endif
 
             sleep_us(100);
         }
@@ -0,0 +1,154 @@
+#pragma once
+
+// Per frame performance counters, built in with -DPERF_COUNTERS=1 (the PERF_COUNTERS cmake option).
+// Without it the PERF_* macros expand to nothing.
+//
+// Time is counted in SysTick cycles of clk_sys on the device and in nanoseconds on the host, for
+// the outermost scope of each counter only, so primitives drawn by other primitives aren't counted
+// twice. Different counters do overlap: PERF_UPDATE includes the conversion and DMA waits done for
+// the update, and a display list renders inside PERF_CONVERT. Each core keeps its own counts, so
+// with the render pipeline core0 shows the drawing and core1 the scanout. A single scope longer
+// than the 24-bit SysTick (134ms at 125MHz) reads short.
+
+#ifndef PERF_COUNTERS
+#define PERF_COUNTERS 0
+#endif
+
+#if PERF_COUNTERS
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+
+#if PICO_ON_DEVICE
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#else
+#include <chrono>
+#endif
+
+enum PerfCounter {
+    PERF_RENDER,    // PicoGraphics primitives
+    PERF_CONVERT,   // framebuffer conversion, excluding the transfer of converted chunks
+    PERF_UPDATE,    // display driver updates, start to return
+    PERF_DMA_WAIT,  // spinning on a transfer to finish
+    PERF_COUNTER_COUNT
+};
+
+struct PerfCore {
+    uint64_t ticks[PERF_COUNTER_COUNT];
+    uint32_t calls[PERF_COUNTER_COUNT];
+    uint8_t depth[PERF_COUNTER_COUNT];
+    uint64_t bytes;   // sent to displays
+    uint32_t frames;  // full display updates
+};
+
+inline PerfCore perf_cores[2];
+inline uint32_t perf_since_us = 0;
+
+#if PICO_ON_DEVICE
+static inline uint32_t perf_ticks() {
+    // each core has its own SysTick, started the first time that core is timed
+    if (!(systick_hw->csr & 1)) {
+        systick_hw->rvr = 0xffffff;
+        systick_hw->cvr = 0;
+        systick_hw->csr = 0b101;  // processor clock, no interrupt, enabled
+    }
+    return systick_hw->cvr;
+}
+
+static inline uint32_t perf_elapsed(uint32_t start, uint32_t end) {
+    return (start - end) & 0xffffff;  // counts down
+}
+
+static inline uint32_t perf_ticks_per_us() {
+    return clock_get_hz(clk_sys) / 1'000'000;
+}
+#else
+static inline uint64_t perf_ticks() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static inline uint64_t perf_elapsed(uint64_t start, uint64_t end) {
+    return end - start;
+}
+
+static inline uint32_t perf_ticks_per_us() {
+    return 1000;
+}
+#endif
+
+class PerfScope {
+    PerfCore & core;
+    PerfCounter const counter;
+    decltype(perf_ticks()) start{};
+
+public:
+    explicit PerfScope(PerfCounter counter) : core(perf_cores[get_core_num()]), counter(counter) {
+        if (core.depth[counter]++ == 0) start = perf_ticks();
+    }
+
+    ~PerfScope() {
+        if (--core.depth[counter] == 0) {
+            core.ticks[counter] += perf_elapsed(start, perf_ticks());
+            core.calls[counter]++;
+        }
+    }
+};
+
+#define PERF_SCOPE(counter) PerfScope perf_scope(counter)
+#define PERF_BYTES(n) (perf_cores[get_core_num()].bytes += (n))
+#define PERF_FRAME() (perf_cores[get_core_num()].frames++)
+
+// Print what each core did since the last report and start counting again. Counts a core adds while
+// the report is printed can be lost.
+static inline void perf_report() {
+    static char const * const names[PERF_COUNTER_COUNT] = {"render", "convert", "update", "dma wait"};
+
+    uint32_t const now = time_us_32();
+    uint32_t const elapsed_us = now - perf_since_us;
+    uint32_t const ticks_per_us = perf_ticks_per_us();
+
+    printf("perf over %dms\n", elapsed_us / 1000);
+    for (uint core = 0; core < 2; core++) {
+        PerfCore & c = perf_cores[core];
+        if (!c.frames && !c.bytes && !c.calls[PERF_RENDER] && !c.calls[PERF_UPDATE]) continue;
+
+        uint32_t const fps_x100 = uint64_t(c.frames) * 100'000'000 / elapsed_us;
+        printf("core%d fps      = %d.%02d\n", core, fps_x100 / 100, fps_x100 % 100);
+        for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+            uint32_t const us = c.ticks[i] / ticks_per_us;
+            printf("core%d %-8s = %dus in %d calls, %d%%\n", core, names[i], us, c.calls[i],
+                   int(uint64_t(us) * 100 / elapsed_us));
+        }
+        printf("core%d sent     = %d bytes, %dkB/s\n", core, int(c.bytes), int(c.bytes * 1000 / elapsed_us));
+
+        // leave the depths alone, a scope may be open on the other core
+        memset(c.ticks, 0, sizeof(c.ticks));
+        memset(c.calls, 0, sizeof(c.calls));
+        c.bytes = 0;
+        c.frames = 0;
+    }
+    printf("\n");
+
+    perf_since_us = now;
+}
+
+// Call from the main loop to report every interval_ms
+static inline void perf_report_every(uint32_t interval_ms) {
+    if (time_us_32() - perf_since_us >= interval_ms * 1000) {
+        perf_report();
+    }
+}
+
+#else
+
+#define PERF_SCOPE(counter)
+#define PERF_BYTES(n)
+#define PERF_FRAME()
+
+#endif
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+
+#include "../ST7789VW/pico_graphics.hpp"
+
+// Renders on core0 while core1 converts and sends the previous frame.
+//
+// The draw loop keeps drawing into the same PicoGraphics and calls present() where it used to call
+// display.update(). present() hands the finished framebuffer to core1 and swaps in a second one to
+// draw the next frame into, waiting only if core1 is still sending the frame before. The swapped in
+// buffer holds the frame from two presents ago, so it has to be redrawn rather than patched.
+//
+// PenT is the pen of the graphics, core1 scans out from its own pen which present() points at the
+// finished framebuffer, along with the damage and palette, so palette changes follow the frame they
+// were made for. A frame only counts as sent once the display is no longer busy, so async display
+// updates are fine, but the display must not be given a back buffer of its own to swap in.
+template<typename PenT>
+class RenderPipeline {
+public:
+    RenderPipeline(DisplayDriver & display, PenT & graphics, void * back_buffer = nullptr)
+            : display(display), graphics(graphics), scanout(graphics), spare(back_buffer) {
+        if (spare == nullptr) {
+            spare = (void *) (new uint8_t[spare_size(graphics)]);
+            owns_spare = true;
+        }
+    }
+
+    ~RenderPipeline() {
+        stop();
+        if (owns_spare) delete[] (uint8_t *) spare;
+    }
+
+    // launch core1, which then waits for frames
+    void start() {
+        if (running) return;
+        active = this;
+        multicore_launch_core1(core1_main);
+        running = true;
+    }
+
+    // wait for the last frame to be sent and return core1
+    void stop() {
+        if (!running) return;
+        wait_for_frame();
+        multicore_fifo_push_blocking(STOP);
+        multicore_fifo_pop_blocking();
+        multicore_reset_core1();
+        running = false;
+        active = nullptr;
+    }
+
+    void present() {
+        if (!running) {
+            display.update(&graphics);
+            return;
+        }
+
+        wait_for_frame();
+
+        // core1 is idle so its pen can be refreshed
+        hand_over();
+        graphics.clear_damage();
+
+        std::swap(graphics.frame_buffer, spare);
+        multicore_fifo_push_blocking(FRAME);
+        in_flight = true;
+    }
+
+    // block until core1 has sent the frame handed over by the last present()
+    void wait_for_frame() {
+        if (!in_flight) return;
+        multicore_fifo_pop_blocking();
+        in_flight = false;
+    }
+
+private:
+    static const uint32_t FRAME = 1;
+    static const uint32_t STOP = 2;
+
+    static inline RenderPipeline * active = nullptr;  // the pipeline core1 runs, there is only one core1
+
+    DisplayDriver & display;
+    PenT & graphics;
+    PenT scanout;
+    void * spare;
+    bool owns_spare = false;
+    bool running = false;
+    bool in_flight = false;
+
+    // the second framebuffer, for the display list the bands core1 rasterizes into
+    static size_t spare_size(const PenT & graphics) {
+        if constexpr (std::is_same_v<PenT, PicoGraphics_PenDisplayList>) {
+            return PenT::buffer_size(graphics.bounds.w, graphics.band_height);
+        } else {
+            return PenT::buffer_size(graphics.bounds.w, graphics.bounds.h);
+        }
+    }
+
+    // Gives the scanout pen what the display reads from it, rather than copying the whole pen with
+    // the draw side caches it never uses
+    void hand_over() {
+        if constexpr (std::is_same_v<PenT, PicoGraphics_PenDisplayList>) {
+            // the frame is the recorded commands, keep the convert buffer already allocated
+            auto convert_buffer = std::move(scanout.convert_buffer);
+            scanout = graphics;
+            scanout.convert_buffer = std::move(convert_buffer);
+            return;
+        }
+
+        scanout.frame_buffer = graphics.frame_buffer;
+        scanout.convert_chunk = graphics.convert_chunk;
+        scanout.track_damage = graphics.track_damage;
+        scanout.damage_tiles = graphics.damage_tiles;
+        scanout.damage_stride = graphics.damage_stride;
+
+        if constexpr (std::is_same_v<PenT, PicoGraphics_PenP4> || std::is_same_v<PenT, PicoGraphics_PenP8>) {
+            // the RGB565 palette scanout built is kept until the palette changes
+            if (memcmp(scanout.palette, graphics.palette, sizeof(graphics.palette)) != 0) {
+                memcpy(scanout.palette, graphics.palette, sizeof(graphics.palette));
+                scanout.palette_rgb565_built = false;
+            }
+        } else if constexpr (std::is_same_v<PenT, PicoGraphics_Pen3Bit>) {
+            memcpy(scanout.palette, graphics.palette, sizeof(graphics.palette));
+        }
+    }
+
+    static void core1_main() {
+        RenderPipeline * self = active;
+
+        while (true) {
+            uint32_t const message = multicore_fifo_pop_blocking();
+            if (message == STOP) break;
+
+            // the framebuffer goes back to core0 once an async update has finished reading it
+            self->display.update(&self->scanout);
+            while (self->display.is_busy()) tight_loop_contents();
+            multicore_fifo_push_blocking(FRAME);
+        }
+
+        multicore_fifo_push_blocking(STOP);
+    }
+};